@@ -0,0 +1,9 @@
+# Benchmark cố định cho bot level 2 / 3 / final, mỗi vị trí in ra một dòng JSON
+# Dùng: bash bench.sh [--depth N] [--nodes N] [--threads N] [--hash MB]
+g++ -O3 -pthread -DBENCH_LEVEL_2 modules/models/bench.cpp -o modules/models/bench_level_2
+g++ -O3 -pthread modules/models/bench.cpp -o modules/models/bench_level_3
+g++ -O3 -pthread -DBENCH_FINAL modules/models/bench.cpp -o modules/models/bench_final
+
+./modules/models/bench_level_2 "$@"
+./modules/models/bench_level_3 "$@"
+./modules/models/bench_final "$@"
@@ -0,0 +1,5 @@
+# Sinh opening book cho bot level 3 / final (đọc qua --book, xem config.py)
+# Dùng: bash book.sh [--plies N] [--radius R] [--time MS] [--threads N]
+g++ -O3 -pthread modules/models/book_builder.cpp -o modules/models/book_builder
+
+./modules/models/book_builder --out modules/models/opening.book "$@"
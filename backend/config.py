@@ -3,5 +3,19 @@ PORT = 5000
 BOARD_SIZE = 20
 WIN_LENGTH = 5
 CURRENT_MODEL = "bot_final"
+BOT_THREADS = 1
+TT_SIZE_MB = 256
+TT_SHARED = True
+SYM_HASH = False
+USE_DFPN = False
+BOT_PONDER = True
+MOVE_BUDGET_MS = 0
+GAME_CLOCK_MS = 0
 PATH_LOGIC = "./modules/logic/engine"
-PATH_MODELS = "./modules/models/"
\ No newline at end of file
+PATH_MODELS = "./modules/models/"
+OPENING_BOOK = "./modules/models/opening.book"
+USE_GAME_HOST = True
+HOSTED_MODELS = ("bot_level_3", "bot_final")
+HOST_WORKERS = 4
+HOST_TIMEOUT_S = 60
+PATH_HOST = "./modules/models/game_host"
\ No newline at end of file
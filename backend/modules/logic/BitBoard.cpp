@@ -0,0 +1,45 @@
+#include "BitBoard.h"
+
+thread_local uint32_t lineBits[2][NUM_LINES];
+uint32_t lineMask[NUM_LINES];
+int lineLen[NUM_LINES];
+int cellLine[BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+int cellPos[BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+thread_local uint32_t rowOccupied[BOARD_SIZE];
+
+static void addLine(int& id, int x, int y, int dir) {
+    int len = 0;
+    for (int cx = x, cy = y; isValid(cx, cy); cx += DIR_X[dir], cy += DIR_Y[dir]) {
+        cellLine[getIdx(cx, cy)][dir] = id;
+        cellPos[getIdx(cx, cy)][dir] = len++;
+    }
+    lineLen[id] = len;
+    lineMask[id] = (1u << len) - 1;
+    id++;
+}
+
+void initBitBoard() {
+    int id = 0;
+    for (int y = 0; y < BOARD_SIZE; y++) addLine(id, 0, y, 0);
+    for (int x = 0; x < BOARD_SIZE; x++) addLine(id, x, 0, 1);
+    for (int k = BOARD_SIZE - 1; k > 0; k--) addLine(id, 0, k, 2);
+    for (int k = 0; k < BOARD_SIZE; k++) addLine(id, k, 0, 2);
+    for (int k = 0; k < BOARD_SIZE; k++) addLine(id, 0, k, 3);
+    for (int k = 1; k < BOARD_SIZE; k++) addLine(id, k, BOARD_SIZE - 1, 3);
+    clearBitBoard();
+}
+
+void clearBitBoard() {
+    std::memset(lineBits, 0, sizeof(lineBits));
+    std::memset(rowOccupied, 0, sizeof(rowOccupied));
+}
+
+void setStone(int idx, int player) {
+    for (int d = 0; d < NUM_DIRS; d++) lineBits[player - 1][cellLine[idx][d]] |= 1u << cellPos[idx][d];
+    rowOccupied[getY(idx)] |= 1u << getX(idx);
+}
+
+void clearStone(int idx, int player) {
+    for (int d = 0; d < NUM_DIRS; d++) lineBits[player - 1][cellLine[idx][d]] &= ~(1u << cellPos[idx][d]);
+    rowOccupied[getY(idx)] &= ~(1u << getX(idx));
+}
@@ -0,0 +1,30 @@
+#ifndef BIT_BOARD_H
+#define BIT_BOARD_H
+
+#include <cstdint>
+#include "ZobristTable.h"
+
+// Every row, column and diagonal is kept as one 32-bit word per player,
+// bit i being the i-th cell along the line.
+const int NUM_DIRS = 4;
+const int NUM_LINES = BOARD_SIZE * 2 + (BOARD_SIZE * 2 - 1) * 2;
+
+constexpr int DIR_X[NUM_DIRS] = {1, 0, 1, 1};
+constexpr int DIR_Y[NUM_DIRS] = {0, 1, 1, -1};
+constexpr int DIR_STEP[NUM_DIRS] = {1, BOARD_SIZE, BOARD_SIZE + 1, 1 - BOARD_SIZE};
+
+extern thread_local uint32_t lineBits[2][NUM_LINES];
+extern uint32_t lineMask[NUM_LINES];
+extern int lineLen[NUM_LINES];
+extern int cellLine[BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+extern int cellPos[BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+extern thread_local uint32_t rowOccupied[BOARD_SIZE];
+
+void initBitBoard();
+void clearBitBoard();
+void setStone(int idx, int player);
+void clearStone(int idx, int player);
+
+inline uint32_t emptyBits(int line) { return lineMask[line] & ~(lineBits[0][line] | lineBits[1][line]); }
+
+#endif
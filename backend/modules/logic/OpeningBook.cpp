@@ -0,0 +1,65 @@
+#include "OpeningBook.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const BookEntry* bookEntries = nullptr;
+static uint32_t bookCount = 0;
+
+// Maps the book read-only; every bot process shares the same page cache
+// copy. A book built for another board size or key set is rejected.
+bool openBook(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open book"); return false; }
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(BookHeader)) {
+        mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mem == MAP_FAILED) { fprintf(stderr, "book: cannot map %s\n", path); return false; }
+
+    const BookHeader* header = (const BookHeader*)mem;
+    if (std::memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 || header->boardSize != BOARD_SIZE
+        || header->zobristCheck != zobrist[0][0]
+        || (size_t)st.st_size < sizeof(BookHeader) + header->count * sizeof(BookEntry)) {
+        fprintf(stderr, "book: %s does not match this engine\n", path);
+        munmap(mem, st.st_size);
+        return false;
+    }
+    bookEntries = (const BookEntry*)(header + 1);
+    bookCount = header->count;
+    return true;
+}
+
+// Looks up the current board; move is mapped back to its orientation.
+bool bookProbe(int& move, BookEntry& entry) {
+    if (bookCount == 0) return false;
+    int sym;
+    uint64_t key = canonicalHash(sym);
+    const BookEntry* end = bookEntries + bookCount;
+    const BookEntry* it = std::lower_bound(bookEntries, end, key, [](const BookEntry& e, uint64_t k) { return e.key < k; });
+    if (it == end || it->key != key) return false;
+    move = fromCanonical(sym, it->move);
+    if (move < 0 || move >= BOARD_SIZE * BOARD_SIZE || board[move] != 0) return false;
+    entry = *it;
+    return true;
+}
+
+bool writeBook(const char* path, std::vector<BookEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    BookHeader header;
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.boardSize = BOARD_SIZE;
+    header.count = entries.size();
+    header.zobristCheck = zobrist[0][0];
+
+    FILE* f = fopen(path, "wb");
+    if (!f) { perror("write book"); return false; }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+        && fwrite(entries.data(), sizeof(BookEntry), entries.size(), f) == entries.size();
+    return fclose(f) == 0 && ok;
+}
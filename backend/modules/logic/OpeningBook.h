@@ -0,0 +1,32 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <cstdint>
+#include <vector>
+#include "ZobristTable.h"
+
+// Book file: a BookHeader followed by count BookEntry records sorted by key.
+// Keys are canonicalHash() values and moves are stored in the canonical
+// orientation, so one entry serves all 8 mirror images of a position.
+const char BOOK_MAGIC[8] = {'G', 'M', 'K', 'B', 'O', 'O', 'K', '1'};
+
+struct BookHeader {
+    char magic[8];
+    uint32_t boardSize;
+    uint32_t count;
+    uint64_t zobristCheck;
+};
+
+struct BookEntry {
+    uint64_t key;
+    int64_t score;
+    int16_t move;
+    int16_t depth;
+    uint32_t reserved;
+};
+
+bool openBook(const char* path);
+bool bookProbe(int& move, BookEntry& entry);
+bool writeBook(const char* path, std::vector<BookEntry>& entries);
+
+#endif
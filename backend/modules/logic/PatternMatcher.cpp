@@ -0,0 +1,55 @@
+#include "PatternMatcher.h"
+
+PatternMatcher::PatternMatcher(const std::vector<Pattern>& patterns, int boardSize) : patterns(patterns) {
+    for (const Pattern& p : patterns) {
+        Compiled c = {(int)p.s.size(), 0, 0, 0};
+        for (int j = 0; j < c.len; j++) {
+            uint32_t& mask = p.s[j] == 'X' ? c.own : p.s[j] == 'O' ? c.other : c.empty;
+            mask |= 1u << j;
+        }
+        compiled.push_back(c);
+    }
+
+    // Same line order as the original string scan; shorter lines hold no five.
+    int n = boardSize;
+    for (int y = 0; y < n; y++) lines.push_back({y * n, 1, n});
+    for (int x = 0; x < n; x++) lines.push_back({x, n, n});
+    for (int d = -(n - 1); d < n; d++) {
+        int y0 = d < 0 ? 0 : d;
+        int len = n - (d < 0 ? -d : d);
+        if (len >= 5) lines.push_back({y0 * n + (y0 - d), n + 1, len});
+    }
+    for (int d = 0; d < n * 2; d++) {
+        int y0 = d < n ? 0 : d - n + 1;
+        int len = (d < n ? d + 1 : 2 * n - 1 - d);
+        if (len >= 5) lines.push_back({y0 * n + (d - y0), n - 1, len});
+    }
+
+    // Rows and columns come first, so the direction of a line follows from
+    // its position in the list.
+    cellLines.assign(n * n, {-1, -1, -1, -1});
+    for (int l = 0; l < (int)lines.size(); l++) {
+        int dir = l < n ? 0 : l < 2 * n ? 1 : lines[l].step == n + 1 ? 2 : 3;
+        for (int i = 0, c = lines[l].start; i < lines[l].len; i++, c += lines[l].step) cellLines[c][dir] = l;
+    }
+}
+
+int PatternMatcher::countDisjoint(uint32_t starts, int len) {
+    int count = 0;
+    while (starts) {
+        int i = __builtin_ctz(starts);
+        count++;
+        starts &= (uint32_t)(~0ull << (i + len));
+    }
+    return count;
+}
+
+// Bit i of the result marks a match starting at cell i of the line.
+uint32_t PatternMatcher::matchStarts(const Compiled& c, uint32_t own, uint32_t other, uint32_t empty) {
+    uint32_t starts = ~0u;
+    for (int j = 0; j < c.len && starts; j++) {
+        uint32_t need = (c.own >> j & 1) ? own : (c.other >> j & 1) ? other : empty;
+        starts &= need >> j;
+    }
+    return starts;
+}
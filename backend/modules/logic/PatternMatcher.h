@@ -0,0 +1,83 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A line pattern over 'X' (own stone), 'O' (opponent stone) and '_' (empty).
+struct Pattern {
+    std::string s;
+    int score;
+};
+
+// Patterns compiled once into per-offset cell masks. A scan packs every row,
+// column and diagonal of the board into own/opponent/empty bit words and
+// matches all patterns for both sides on those words, counting
+// non-overlapping occurrences exactly like repeated string::find would.
+class PatternMatcher {
+public:
+    PatternMatcher(const std::vector<Pattern>& patterns, int boardSize);
+
+    // Calls fn(pattern, mine, theirs) for every line of at least 5 cells and
+    // every pattern, in line order (rows, columns, diagonals, anti-diagonals).
+    // theirs counts the pattern with the two players swapped.
+    template <class F>
+    void scan(const int* cells, int me, int opp, F&& fn) const;
+
+    // The same for one line, so callers can keep per-line scores and only
+    // rescan the lines through a move.
+    template <class F>
+    void scanLine(int line, const int* cells, int me, int opp, F&& fn) const;
+
+    int numLines() const { return (int)lines.size(); }
+
+    // Line through cell along row, column, diagonal or anti-diagonal
+    // (dir 0-3), or -1 when that line is shorter than 5 cells.
+    int lineThrough(int cell, int dir) const { return cellLines[cell][dir]; }
+
+private:
+    // Bit j of own/other/empty says what cell j of the pattern must hold.
+    struct Compiled {
+        int len;
+        uint32_t own, other, empty;
+    };
+
+    struct Line {
+        int start;
+        int step;
+        int len;
+    };
+
+    std::vector<Pattern> patterns;
+    std::vector<Compiled> compiled;
+    std::vector<Line> lines;
+    std::vector<std::array<int, 4>> cellLines;
+
+    static int countDisjoint(uint32_t starts, int len);
+    static uint32_t matchStarts(const Compiled& c, uint32_t own, uint32_t other, uint32_t empty);
+};
+
+template <class F>
+void PatternMatcher::scan(const int* cells, int me, int opp, F&& fn) const {
+    for (int l = 0; l < numLines(); l++) scanLine(l, cells, me, opp, fn);
+}
+
+template <class F>
+void PatternMatcher::scanLine(int l, const int* cells, int me, int opp, F&& fn) const {
+    const Line& line = lines[l];
+    uint32_t mine = 0, theirs = 0, empty = 0;
+    for (int i = 0, c = line.start; i < line.len; i++, c += line.step) {
+        if (cells[c] == me) mine |= 1u << i;
+        else if (cells[c] == opp) theirs |= 1u << i;
+        else empty |= 1u << i;
+    }
+    for (size_t k = 0; k < compiled.size(); k++) {
+        const Compiled& c = compiled[k];
+        fn(patterns[k], countDisjoint(matchStarts(c, mine, theirs, empty), c.len),
+           countDisjoint(matchStarts(c, theirs, mine, empty), c.len));
+    }
+}
+
+#endif
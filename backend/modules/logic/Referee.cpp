@@ -0,0 +1,33 @@
+#include "Referee.h"
+
+template <int N>
+void Referee<N>::reset() {
+    std::memset(cells, 0, sizeof(cells));
+    std::memset(runLen, 0, sizeof(runLen));
+    std::memset(grid, WALL, sizeof(grid));
+    for (int i = 0; i < N * N; i++) grid[padded(i)] = 0;
+    stones = 0;
+}
+
+template <int N>
+int Referee<N>::play(int idx, int player) {
+    if (idx < 0 || idx >= N * N || cells[idx] != 0) return REF_ILLEGAL;
+    cells[idx] = player;
+    stones++;
+
+    int at = padded(idx);
+    grid[at] = player;
+    bool won = false;
+    for (int d = 0; d < NUM_DIRS; d++) {
+        int step = STEP[d];
+        int below = grid[at - step] == player ? runLen[d][at - step] : 0;
+        int above = grid[at + step] == player ? runLen[d][at + step] : 0;
+
+        int len = below + above + 1;
+        runLen[d][at - below * step] = len;
+        runLen[d][at + above * step] = len;
+        runLen[d][at] = len;
+        if (len >= WIN_LEN) won = true;
+    }
+    return won ? REF_WIN : REF_PLAYED;
+}
@@ -0,0 +1,37 @@
+#ifndef REFEREE_H
+#define REFEREE_H
+
+#include <cstdint>
+#include "BitBoard.h"
+
+const int WIN_LEN = 5;
+
+const int REF_ILLEGAL = -1;
+const int REF_PLAYED = 0;
+const int REF_WIN = 1;
+
+// Freestyle rules referee (five or more in a row wins) for one game on an
+// N x N board. Moves and cells use the
+// search board layout (y * N + x). Internally stones live on a grid padded
+// with a wall on every side, so neighbour reads need no bounds checks.
+// Every run of stones stores its length at both of its end cells, so a new
+// stone only reads its two neighbours per direction to know the run it makes.
+template <int N>
+struct Referee {
+    static constexpr int STRIDE = N + 2;
+    static constexpr int GRID = STRIDE * STRIDE;
+    static constexpr int WALL = 3;
+    static constexpr int STEP[NUM_DIRS] = {1, STRIDE, STRIDE + 1, 1 - STRIDE};
+
+    static constexpr int padded(int idx) { return (idx / N + 1) * STRIDE + idx % N + 1; }
+
+    int cells[N * N];
+    uint8_t grid[GRID];
+    uint8_t runLen[NUM_DIRS][GRID];
+    int stones;
+
+    void reset();
+    int play(int idx, int player);
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SEARCH_INFO_H
+#define SEARCH_INFO_H
+
+#include <vector>
+
+// Outcome of the last solve(), for tools that drive the search directly.
+struct SearchInfo {
+    int depth;
+    int selDepth;
+    long long score;
+    int bestMove;
+    long long nodes;
+    std::vector<long long> depthMs;
+    std::vector<int> pv;
+    long long threatMs;
+    bool threatWin;
+    bool threatTimeout;
+
+    void reset() {
+        depth = 0;
+        selDepth = 0;
+        score = 0;
+        bestMove = -1;
+        nodes = 0;
+        depthMs.clear();
+        pv.clear();
+        threatMs = 0;
+        threatWin = false;
+        threatTimeout = false;
+    }
+};
+
+#endif
@@ -1,12 +1,78 @@
 #include "ZobristTable.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
 
-TTEntry TTable[TT_TABLE_SIZE];
+TTBucket* TTable = nullptr;
+uint64_t ttBuckets = 0;
+int ttSizeMB = TT_DEFAULT_MB;
+const char* ttShmName = nullptr;
+bool ttHugePages = false;
+static TTHeader* ttHeader = nullptr;
+static int ttShmFd = -1;
+static int requestedBoardSize = 0;
 uint64_t zobrist[BOARD_SIZE * BOARD_SIZE][2];
 uint64_t zobristTurn;
-uint64_t currentHash = 0;
-int board[BOARD_SIZE * BOARD_SIZE];
+thread_local uint64_t currentHash = 0;
+thread_local int board[BOARD_SIZE * BOARD_SIZE];
+thread_local long long ttProbes = 0;
+thread_local long long ttHits = 0;
+int symCell[NUM_SYMMETRIES][BOARD_SIZE * BOARD_SIZE];
+int symInverse[NUM_SYMMETRIES];
+bool symHashing = false;
+thread_local uint64_t symHash[NUM_SYMMETRIES];
+
+// Meta word layout: key[63:32] gen[31:19] valid[18] depth[17:12] flag[11:10] move+1[9:0]
+static const uint64_t META_VALID = 1ull << 18;
+static const uint32_t GEN_MASK = 0x1FFF;
+// Ages saturate, so an entry that has sat through more searches than this
+// only competes on depth.
+static const int TT_MAX_AGE = 16;
+
+static inline uint32_t currentGeneration() { return ttHeader->generation.load(std::memory_order_relaxed) & GEN_MASK; }
+
+static inline uint64_t packMeta(uint64_t key, int depth, int flag, int bestMove) {
+    return (key & 0xFFFFFFFF00000000ull) | META_VALID
+        | ((uint64_t)currentGeneration() << 19)
+        | ((uint64_t)(depth & 0x3F) << 12)
+        | ((uint64_t)(flag & 3) << 10)
+        | (uint64_t)((bestMove + 1) & 0x3FF);
+}
+
+static inline int metaDepth(uint64_t meta) { return (meta >> 12) & 0x3F; }
+static inline int metaAge(uint64_t meta) {
+    return std::min<int>((currentGeneration() - (uint32_t)(meta >> 19)) & GEN_MASK, TT_MAX_AGE);
+}
+
+// Bit 2 of s transposes the board, then bit 0 mirrors x and bit 1 mirrors y.
+static void initSymmetry() {
+    for (int s = 0; s < NUM_SYMMETRIES; s++) {
+        for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+            int x = getX(i), y = getY(i);
+            if (s & 4) std::swap(x, y);
+            if (s & 1) x = BOARD_SIZE - 1 - x;
+            if (s & 2) y = BOARD_SIZE - 1 - y;
+            symCell[s][i] = getIdx(x, y);
+        }
+    }
+    for (int s = 0; s < NUM_SYMMETRIES; s++) {
+        for (int t = 0; t < NUM_SYMMETRIES; t++) {
+            bool undoes = true;
+            for (int i = 0; i < BOARD_SIZE * BOARD_SIZE && undoes; i++) undoes = symCell[t][symCell[s][i]] == i;
+            if (undoes) symInverse[s] = t;
+        }
+    }
+}
 
 void initZobrist() {
+    initSymmetry();
     std::mt19937_64 rng(RNG_SEED);
     for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
         zobrist[i][0] = rng();
@@ -14,11 +80,280 @@ void initZobrist() {
     }
     zobristTurn = rng();
     std::memset(board, 0, sizeof(board));
-    std::memset(TTable, 0, sizeof(TTable));
+    resetHash();
+}
+
+bool parseTTOption(const char* flag, const char* value) {
+    if (std::strcmp(flag, "--hash") == 0) ttSizeMB = std::max(1, std::atoi(value));
+    else if (std::strcmp(flag, "--shared-hash") == 0) ttShmName = value;
+    else if (std::strcmp(flag, "--huge-pages") == 0) ttHugePages = std::atoi(value) != 0;
+    else if (std::strcmp(flag, "--sym-hash") == 0) symHashing = std::atoi(value) != 0;
+    else if (std::strcmp(flag, "--size") == 0) requestedBoardSize = std::atoi(value);
+    else return false;
+    return true;
+}
+
+// POSIX shm names live under /dev/shm on Linux; link() and rename() on
+// that path publish a table under its name atomically.
+static std::string shmPath(const std::string& name) { return "/dev/shm" + name; }
+
+static bool sameObject(int fd, const char* name) {
+    struct stat mine, named;
+    return fstat(fd, &mine) == 0 && stat(shmPath(name).c_str(), &named) == 0 && mine.st_ino == named.st_ino;
+}
+
+static bool validSharedTT(int fd, size_t bytes) {
+    struct stat st;
+    TTHeader header;
+    return fstat(fd, &st) == 0 && (size_t)st.st_size == bytes
+        && pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+        && header.boardSize == BOARD_SIZE && header.zobristCheck == zobrist[0][0];
+}
+
+// Builds a complete table under a private name, then publishes it as
+// ttShmName: link() when there is none yet, so of two processes starting
+// together exactly one wins, rename() to replace an incompatible one.
+// Returns the descriptor, -1 on error, or -2 when another table won.
+static int publishSharedTT(size_t bytes, bool replace) {
+    std::string temp = std::string(ttShmName) + "." + std::to_string(getpid());
+    int fd = shm_open(temp.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) { perror("shm_open"); return -1; }
+    TTHeader header;
+    header.generation.store(0);
+    header.boardSize = BOARD_SIZE;
+    header.zobristCheck = zobrist[0][0];
+    flock(fd, LOCK_SH);
+    bool built = ftruncate(fd, bytes) == 0 && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    if (!built) perror("ftruncate");
+
+    bool published = false;
+    if (built && replace) published = rename(shmPath(temp).c_str(), shmPath(ttShmName).c_str()) == 0;
+    else if (built) published = link(shmPath(temp).c_str(), shmPath(ttShmName).c_str()) == 0;
+    bool lost = built && !replace && !published && errno == EEXIST;
+    if (!published) {
+        if (!lost) perror("publish shared table");
+        shm_unlink(temp.c_str());
+        close(fd);
+        return lost ? -2 : -1;
+    }
+    if (!replace) shm_unlink(temp.c_str());
+    return fd;
+}
+
+// Every process attached to the shared table holds a shared flock on it; the
+// last one to leave removes it (ttRelease). Tables only appear under the
+// name fully built, so a table that is there but sized or keyed for another
+// build is replaced; processes still mapping it keep using the old one.
+static void* mapSharedTT(size_t bytes) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        int fd = shm_open(ttShmName, O_RDWR, 0600);
+        if (fd < 0) {
+            if (errno != ENOENT) { perror("shm_open"); return MAP_FAILED; }
+            fd = publishSharedTT(bytes, false);
+        } else {
+            flock(fd, LOCK_SH);
+            if (!sameObject(fd, ttShmName)) {
+                // The last user removed it while we were attaching.
+                close(fd);
+                continue;
+            }
+            if (!validSharedTT(fd, bytes)) {
+                fprintf(stderr, "tt: %s was built for another --hash or board, replacing it\n", ttShmName);
+                close(fd);
+                fd = publishSharedTT(bytes, true);
+            }
+        }
+        if (fd == -2) continue;
+        if (fd < 0) return MAP_FAILED;
+
+        void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) { perror("mmap"); close(fd); return MAP_FAILED; }
+        ttShmFd = fd;
+        return mem;
+    }
+    fprintf(stderr, "tt: cannot attach %s\n", ttShmName);
+    return MAP_FAILED;
+}
+
+// Maps the table: private anonymous memory by default, or the POSIX shared
+// memory object ttShmName, created on first use and attached by later
+// processes. Pages are only committed as they are touched, so nothing is
+// cleared up front. Every bot calls it at startup, so it also refuses a
+// --size other than the board the bot was compiled for.
+bool initTT() {
+    if (requestedBoardSize && requestedBoardSize != BOARD_SIZE) {
+        fprintf(stderr, "built for a %d board, not %d: rebuild with BOARD_SIZE=%d bash run.sh\n",
+                BOARD_SIZE, requestedBoardSize, requestedBoardSize);
+        return false;
+    }
+    // --hash is the size of the buckets; the header comes on top of it.
+    ttBuckets = 1;
+    while (ttBuckets * 2 * sizeof(TTBucket) <= ((uint64_t)ttSizeMB << 20)) ttBuckets *= 2;
+    size_t bytes = ttBuckets * sizeof(TTBucket) + sizeof(TTHeader);
+
+    void* mem = MAP_FAILED;
+    if (ttShmName) {
+        mem = mapSharedTT(bytes);
+        if (mem == MAP_FAILED) return false;
+        atexit(ttRelease);
+    } else {
+#ifdef MAP_HUGETLB
+        if (ttHugePages) mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (mem == MAP_FAILED) mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) { perror("mmap"); return false; }
+    }
+#ifdef MADV_HUGEPAGE
+    if (ttHugePages) madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+
+    ttHeader = (TTHeader*)mem;
+    TTable = (TTBucket*)((char*)mem + sizeof(TTHeader));
+    return true;
+}
+
+// Detaches from the shared table; the last process to leave removes it,
+// unless the name has since been given to a replacement table.
+void ttRelease() {
+    if (ttShmFd < 0) return;
+    if (flock(ttShmFd, LOCK_EX | LOCK_NB) == 0) {
+        if (sameObject(ttShmFd, ttShmName)) shm_unlink(ttShmName);
+    }
+    close(ttShmFd);
+    ttShmFd = -1;
+}
+
+// Hash of the empty board; the caller clears the board itself.
+void resetHash() {
     currentHash = zobristTurn;
+    for (int s = 0; s < NUM_SYMMETRIES; s++) symHash[s] = zobristTurn;
 }
 
 void toggleHash(int idx, int player) {
     currentHash ^= zobrist[idx][player - 1];
     currentHash ^= zobristTurn;
-}
\ No newline at end of file
+    if (symHashing) {
+        for (int s = 0; s < NUM_SYMMETRIES; s++) symHash[s] ^= zobrist[symCell[s][idx]][player - 1] ^ zobristTurn;
+    }
+}
+
+// Smallest hash of the board over all its symmetries; sym is the symmetry
+// that produced it, so a move m of that orientation is symCell[symInverse[sym]][m] here.
+uint64_t canonicalHash(int& sym) {
+    if (symHashing) {
+        sym = 0;
+        for (int s = 1; s < NUM_SYMMETRIES; s++) {
+            if (symHash[s] < symHash[sym]) sym = s;
+        }
+        return symHash[sym];
+    }
+    uint64_t hashes[NUM_SYMMETRIES];
+    for (int s = 0; s < NUM_SYMMETRIES; s++) hashes[s] = zobristTurn;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        if (board[i] == 0) continue;
+        for (int s = 0; s < NUM_SYMMETRIES; s++) hashes[s] ^= zobrist[symCell[s][i]][board[i] - 1] ^ zobristTurn;
+    }
+    sym = 0;
+    for (int s = 1; s < NUM_SYMMETRIES; s++) {
+        if (hashes[s] < hashes[sym]) sym = s;
+    }
+    return hashes[sym];
+}
+
+// Cache key of the board: the canonical hash with --sym-hash, else currentHash.
+uint64_t positionKey(int& sym) {
+    if (symHashing) return canonicalHash(sym);
+    sym = 0;
+    return currentHash;
+}
+
+// positionKey() of the board after player plays idx, without playing it.
+uint64_t childKey(int idx, int player) {
+    if (!symHashing) return currentHash ^ zobrist[idx][player - 1] ^ zobristTurn;
+    uint64_t best = ~0ull;
+    for (int s = 0; s < NUM_SYMMETRIES; s++) {
+        best = std::min(best, symHash[s] ^ zobrist[symCell[s][idx]][player - 1] ^ zobristTurn);
+    }
+    return best;
+}
+
+bool ttProbePosition(TTEntry& entry) {
+    int sym;
+    if (!ttProbe(positionKey(sym), entry)) return false;
+    entry.bestMove = fromCanonical(sym, entry.bestMove);
+    return true;
+}
+
+void ttStorePosition(int depth, long long score, int flag, int bestMove) {
+    int sym;
+    uint64_t key = positionKey(sym);
+    ttStore(key, depth, score, flag, toCanonical(sym, bestMove));
+}
+
+bool ttProbe(uint64_t key, TTEntry& entry) {
+    TTBucket& bucket = TTable[key & (ttBuckets - 1)];
+    ttProbes++;
+    for (int s = 0; s < TT_BUCKET_SIZE; s++) {
+        uint64_t data = bucket.slots[s][1].load(std::memory_order_relaxed);
+        uint64_t meta = bucket.slots[s][0].load(std::memory_order_relaxed) ^ data;
+        if (!(meta & META_VALID) || (meta >> 32) != (key >> 32)) continue;
+        ttHits++;
+        entry.key = key;
+        entry.depth = metaDepth(meta);
+        entry.score = (long long)data;
+        entry.flag = (meta >> 10) & 3;
+        entry.bestMove = (int)(meta & 0x3FF) - 1;
+        return true;
+    }
+    return false;
+}
+
+// Overwrites the slot holding the same position, otherwise the slot with the
+// lowest depth after a penalty for every search generation it has aged.
+void ttStore(uint64_t key, int depth, long long score, int flag, int bestMove) {
+    TTBucket& bucket = TTable[key & (ttBuckets - 1)];
+    int victim = 0;
+    int victimValue = 1 << 30;
+    for (int s = 0; s < TT_BUCKET_SIZE; s++) {
+        uint64_t data = bucket.slots[s][1].load(std::memory_order_relaxed);
+        uint64_t meta = bucket.slots[s][0].load(std::memory_order_relaxed) ^ data;
+        int value;
+        if (!(meta & META_VALID)) value = -(1 << 29);
+        else if ((meta >> 32) == (key >> 32)) {
+            if (bestMove == -1) bestMove = (int)(meta & 0x3FF) - 1;
+            victim = s;
+            break;
+        } else value = metaDepth(meta) - 4 * metaAge(meta);
+        if (value < victimValue) { victim = s; victimValue = value; }
+    }
+    uint64_t data = (uint64_t)score;
+    bucket.slots[victim][0].store(packMeta(key, depth, flag, bestMove) ^ data, std::memory_order_relaxed);
+    bucket.slots[victim][1].store(data, std::memory_order_relaxed);
+}
+
+void ttClear() {
+    for (uint64_t b = 0; b < ttBuckets; b++) {
+        for (int s = 0; s < TT_BUCKET_SIZE; s++) {
+            TTable[b].slots[s][0].store(0, std::memory_order_relaxed);
+            TTable[b].slots[s][1].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Per mille of sampled slots written during the current search generation.
+int ttHashfull() {
+    uint64_t sample = std::min<uint64_t>(ttBuckets, 1000);
+    uint64_t used = 0;
+    for (uint64_t b = 0; b < sample; b++) {
+        for (int s = 0; s < TT_BUCKET_SIZE; s++) {
+            uint64_t data = TTable[b].slots[s][1].load(std::memory_order_relaxed);
+            uint64_t meta = TTable[b].slots[s][0].load(std::memory_order_relaxed) ^ data;
+            if ((meta & META_VALID) && metaAge(meta) == 0) used++;
+        }
+    }
+    return sample ? (int)(used * 1000 / (sample * TT_BUCKET_SIZE)) : 0;
+}
+
+void ttNewSearch() {
+    ttHeader->generation.fetch_add(1, std::memory_order_relaxed);
+}
@@ -4,10 +4,21 @@
 #include <cstdint>
 #include <random>
 #include <cstring>
+#include <atomic>
 
-const int BOARD_SIZE = 20;
-const int TT_TABLE_SIZE = 1 << 22;
+// Override with -DGOMOKU_BOARD_SIZE=15 to build the engine for another board.
+#ifndef GOMOKU_BOARD_SIZE
+#define GOMOKU_BOARD_SIZE 20
+#endif
+
+const int BOARD_SIZE = GOMOKU_BOARD_SIZE;
+// Lines are 32-bit words built with (1u << len) - 1, and TT entries pack
+// move + 1 into 10 bits, so 31 is the largest board either allows.
+static_assert(BOARD_SIZE >= 5 && BOARD_SIZE <= 31, "board too large for line words and TT moves");
+const int TT_DEFAULT_MB = 64;
+const int TT_BUCKET_SIZE = 4;
 const int RNG_SEED = 12345;
+const int NUM_SYMMETRIES = 8;
 
 const int FLAG_EXACT = 0;
 const int FLAG_LOWERBOUND = 1;
@@ -21,18 +32,74 @@ struct TTEntry {
     int bestMove;
 };
 
-extern TTEntry TTable[TT_TABLE_SIZE];
+// A slot is two words: the score, and the packed key check / depth / flag /
+// move / generation XOR-ed with the score, so a torn write never verifies.
+struct alignas(64) TTBucket {
+    std::atomic<uint64_t> slots[TT_BUCKET_SIZE][2];
+};
+
+// Lives at the start of the table mapping. The generation is the one clock
+// every search writing to the table ages entries by, across threads, games
+// and processes. A shared table is only attached when it was built for the
+// same board size and Zobrist keys.
+struct alignas(64) TTHeader {
+    std::atomic<uint32_t> generation;
+    uint32_t boardSize;
+    uint64_t zobristCheck;
+};
+
+extern TTBucket* TTable;
+extern uint64_t ttBuckets;
+extern int ttSizeMB;
+extern const char* ttShmName;
+extern bool ttHugePages;
 extern uint64_t zobrist[BOARD_SIZE * BOARD_SIZE][2];
 extern uint64_t zobristTurn;
-extern uint64_t currentHash;
-extern int board[BOARD_SIZE * BOARD_SIZE];
+extern thread_local uint64_t currentHash;
+extern thread_local int board[BOARD_SIZE * BOARD_SIZE];
+extern thread_local long long ttProbes;
+extern thread_local long long ttHits;
+
+// symCell[s][idx] is where idx lands under board symmetry s (s = 0 is the
+// identity); symInverse[s] undoes s.
+extern int symCell[NUM_SYMMETRIES][BOARD_SIZE * BOARD_SIZE];
+extern int symInverse[NUM_SYMMETRIES];
+
+// With --sym-hash 1 the hash of every symmetric image of the board is kept
+// up to date (symHash[0] == currentHash), and the *Position TT calls key on
+// the smallest of them, storing moves in that canonical orientation.
+extern bool symHashing;
+extern thread_local uint64_t symHash[NUM_SYMMETRIES];
 
 void initZobrist();
+void resetHash();
 void toggleHash(int idx, int player);
+uint64_t canonicalHash(int& sym);
+uint64_t positionKey(int& sym);
+uint64_t childKey(int idx, int player);
+bool ttProbePosition(TTEntry& entry);
+void ttStorePosition(int depth, long long score, int flag, int bestMove);
+bool parseTTOption(const char* flag, const char* value);
+bool initTT();
+void ttRelease();
+bool ttProbe(uint64_t key, TTEntry& entry);
+void ttStore(uint64_t key, int depth, long long score, int flag, int bestMove);
+void ttNewSearch();
+void ttClear();
+int ttHashfull();
 
 inline int getIdx(int x, int y) { return y * BOARD_SIZE + x; }
 inline int getX(int idx) { return idx % BOARD_SIZE; }
 inline int getY(int idx) { return idx / BOARD_SIZE; }
 inline bool isValid(int x, int y) { return x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE; }
 
-#endif
\ No newline at end of file
+// Moves between the board's orientation and that of symmetry sym; -1 and
+// other non-cells pass through.
+inline int toCanonical(int sym, int move) {
+    return move >= 0 && move < BOARD_SIZE * BOARD_SIZE ? symCell[sym][move] : move;
+}
+inline int fromCanonical(int sym, int move) {
+    return move >= 0 && move < BOARD_SIZE * BOARD_SIZE ? symCell[symInverse[sym]][move] : move;
+}
+
+#endif
@@ -1,33 +1,14 @@
 #include <iostream>
-#include <vector>
+#include "Referee.cpp"
 using namespace std;
-const int SIZE = 20;
-const int WIN_LEN = 5;
-int board[SIZE * SIZE] = {0};
-bool is_valid(int r, int c) { return r >= 0 && r < SIZE && c >= 0 && c < SIZE; }
-bool check_win(int idx, int player) {
-    int r = idx / SIZE, c = idx % SIZE;
-    int dr[] = {1, 0, 1, 1}, dc[] = {0, 1, 1, -1};
-    for (int i = 0; i < 4; i++) {
-        int count = 1;
-        for (int s = 1; s < WIN_LEN; s++) {
-            if (!is_valid(r + s*dr[i], c + s*dc[i]) || board[(r + s*dr[i])*SIZE + c + s*dc[i]] != player) break;
-            count++;
-        }
-        for (int s = 1; s < WIN_LEN; s++) {
-            if (!is_valid(r - s*dr[i], c - s*dc[i]) || board[(r - s*dr[i])*SIZE + c - s*dc[i]] != player) break;
-            count++;
-        }
-        if (count >= WIN_LEN) return true;
-    }
-    return false;
-}
+
+// Board size is the GOMOKU_BOARD_SIZE build flag, same as the bots.
 int main() {
+    static Referee<BOARD_SIZE> referee;
+    referee.reset();
     int idx, player;
     while (cin >> idx >> player) {
-        if (idx < 0 || idx >= SIZE * SIZE || board[idx] != 0) { cout << -1 << endl; continue; }
-        board[idx] = player;
-        cout << (check_win(idx, player) ? 1 : 0) << endl;
+        cout << referee.play(idx, player) << endl;
     }
     return 0;
-}
\ No newline at end of file
+}
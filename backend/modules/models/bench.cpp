@@ -0,0 +1,153 @@
+#define LIB_MODE
+#if defined(BENCH_LEVEL_2)
+#include "bot_level_2.cpp"
+const char* BENCH_BOT = "bot_level_2";
+#elif defined(BENCH_FINAL)
+#include "bot_level_3.cpp"
+const char* BENCH_BOT = "bot_final";
+#else
+#include "bot_level_3.cpp"
+const char* BENCH_BOT = "bot_level_3";
+#endif
+#include <sstream>
+
+// Fixed-position benchmark. Every position is searched from empty tables to a
+// fixed depth (or node budget) and reported as one JSON object per line. The
+// solve lines time alpha-beta alone; the threat solvers get their own lines.
+// Usage: bench [--depth N] [--nodes N] [bot options]
+
+struct BenchPosition {
+    const char* name;
+    const char* moves;
+};
+
+const BenchPosition BENCH_POSITIONS[] = {
+    {"opening", "K11 J11"},
+    {"early", "K11 J11 K10 K12 I10 J10 J9 J12"},
+    {"middle", "K11 J11 K10 K12 I10 J10 J9 J12 K9 J13 J14 K8 I9 L9"},
+    {"busy", "K11 J11 K10 K12 I10 J10 J9 J12 K9 J13 J14 K8 I9 L9 I8 H9 I11 I7 I12 I13 L11 H7 M12 N13 J7"},
+    {"crowded", "K11 J11 K10 K12 I10 J10 J9 J12 K9 J13 J14 K8 I9 L9 I8 H9 I11 I7 I12 I13 L11 H7 M12 N13 J7 O14 H12"},
+    {"vcf", "K11 J11 K10 K12 I10 J10 J9 J12 K9 J13 J14 K8 I9 L9 I8 H9"},
+    {"vct", "K11 J11 K10 K12 I10 J10 J9 J12 K9 J13 J14 K8"},
+};
+
+int str_to_move(const string& s) {
+    return getIdx(s[0] - 'A', stoi(s.substr(1)) - 1);
+}
+
+vector<int> positionCells(const BenchPosition& pos, int& stones) {
+    vector<int> cells(BOARD_SIZE * BOARD_SIZE, 0);
+    istringstream in(pos.moves);
+    string mv;
+    stones = 0;
+    while (in >> mv) cells[str_to_move(mv)] = (stones++ % 2 == 0) ? 1 : 2;
+    return cells;
+}
+
+void setupPosition(const vector<int>& cells) {
+#ifdef BENCH_LEVEL_2
+    memset(board, 0, sizeof(board));
+    resetHash();
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        if (cells[i] != 0) { board[i] = cells[i]; toggleHash(i, cells[i]); }
+    }
+#else
+    loadPosition(cells.data());
+#endif
+}
+
+long long elapsedMs(chrono::steady_clock::time_point since) {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - since).count();
+}
+
+void benchSolve(const BenchPosition& pos) {
+    int stones;
+    vector<int> cells = positionCells(pos, stones);
+    setupPosition(cells);
+    myID = (stones % 2 == 0) ? 1 : 2;
+    opID = 3 - myID;
+    ttClear();
+    memset(history, 0, sizeof(history));
+    memset(killerMoves, 0, sizeof(killerMoves));
+#ifndef BENCH_LEVEL_2
+    threatCacheClear();
+#endif
+    ttProbes = ttHits = 0;
+
+    auto start = chrono::steady_clock::now();
+    int best = solve();
+    long long ms = elapsedMs(start);
+
+    cout << "{\"bot\":\"" << BENCH_BOT << "\",\"position\":\"" << pos.name << "\",\"search\":\"solve\""
+         << ",\"depth\":" << searchInfo.depth
+         << ",\"best\":\"" << move_to_str(best) << "\""
+         << ",\"score\":" << searchInfo.score
+         << ",\"nodes\":" << searchInfo.nodes
+         << ",\"ms\":" << ms
+         << ",\"nps\":" << (ms > 0 ? searchInfo.nodes * 1000 / ms : searchInfo.nodes * 1000)
+         << ",\"tt_hit_rate\":" << fixed << setprecision(4) << (ttProbes ? (double)ttHits / ttProbes : 0.0)
+         << defaultfloat << ",\"depth_ms\":[";
+    for (size_t i = 0; i < searchInfo.depthMs.size(); i++) cout << (i ? "," : "") << searchInfo.depthMs[i];
+    cout << "]}" << endl;
+}
+
+#ifndef BENCH_LEVEL_2
+void benchThreats(const BenchPosition& pos) {
+    int stones;
+    vector<int> cells = positionCells(pos, stones);
+    int p = (stones % 2 == 0) ? 1 : 2;
+
+    const char* solvers[] = {"vcf", "vct", "dfpn"};
+    for (int k = 0; k < 3; k++) {
+        setupPosition(cells);
+        threatCacheClear();
+        startTime = chrono::steady_clock::now();
+        timeOut = false;
+        int winMove = -1;
+        bool win = k == 0 ? solveVCF(VCT_DEPTH, p, winMove)
+                 : k == 1 ? solveVCT(VCT_DEPTH, p, winMove)
+                 : proveWin(p, false, winMove);
+        long long ms = elapsedMs(startTime);
+
+        cout << "{\"bot\":\"" << BENCH_BOT << "\",\"position\":\"" << pos.name << "\",\"search\":\"" << solvers[k] << "\""
+             << ",\"win\":" << (win ? "true" : "false")
+             << ",\"move\":\"" << move_to_str(win ? winMove : -1) << "\""
+             << ",\"timeout\":" << (timeOut ? "true" : "false")
+             << ",\"ms\":" << ms << "}" << endl;
+    }
+}
+#endif
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    int depth = 5;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--depth") == 0) depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--nodes") == 0) nodeLimit = atoll(argv[++i]);
+    }
+    depthLimit = max(1, min(depth, MAX_SEARCH_DEPTH));
+    timeLimitMs = 1 << 30;
+#ifndef BENCH_LEVEL_2
+    USE_THREAT_PASS = false;
+#endif
+#ifdef BENCH_FINAL
+    DEFENSE_SCALE = 1.2;
+#endif
+
+    initZobrist();
+    if (!initTT()) return 1;
+#ifndef BENCH_LEVEL_2
+    initSearch();
+#endif
+    ostringstream quiet;
+    cerr.rdbuf(quiet.rdbuf());
+
+    for (const BenchPosition& pos : BENCH_POSITIONS) {
+        benchSolve(pos);
+#ifndef BENCH_LEVEL_2
+        benchThreats(pos);
+#endif
+        quiet.str("");
+    }
+    return 0;
+}
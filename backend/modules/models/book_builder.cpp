@@ -0,0 +1,85 @@
+#define LIB_MODE
+#include "bot_level_3.cpp"
+#include <set>
+
+// Opening book builder. For each colour the book side can play, it walks the
+// first --plies stones: the opponent may play any cell within --radius of a
+// stone (of the center for the first move), the book side plays the move
+// found by a full solve() of --time ms. Every book-side position is stored
+// once per symmetry class.
+// Usage: book_builder [--plies N] [--radius R] [--time MS] [--out PATH] [bot options]
+
+int BOOK_PLIES = 4;
+int BOOK_RADIUS = 1;
+const char* outPath = "modules/models/opening.book";
+
+vector<BookEntry> entries;
+set<uint64_t> seen;
+
+bool nearStone(const vector<int>& cells, int idx, int stones) {
+    int x = getX(idx), y = getY(idx);
+    if (stones == 0) return max(abs(x - BOARD_SIZE / 2), abs(y - BOARD_SIZE / 2)) <= BOOK_RADIUS;
+    for (int dy = -BOOK_RADIUS; dy <= BOOK_RADIUS; dy++) {
+        for (int dx = -BOOK_RADIUS; dx <= BOOK_RADIUS; dx++) {
+            if (isValid(x + dx, y + dy) && cells[getIdx(x + dx, y + dy)] != 0) return true;
+        }
+    }
+    return false;
+}
+
+void expand(vector<int>& cells, int stones, int bookSide) {
+    if (stones >= BOOK_PLIES) return;
+    int toMove = (stones % 2 == 0) ? 1 : 2;
+    loadPosition(cells.data());
+    int sym;
+    uint64_t key = canonicalHash(sym);
+
+    if (toMove == bookSide) {
+        if (!seen.insert(key).second) return;
+        myID = toMove;
+        opID = 3 - toMove;
+        int best = solve();
+        entries.push_back({key, searchInfo.score, (int16_t)toCanonical(sym, best), (int16_t)searchInfo.depth, 0});
+        cerr << "book " << entries.size() << ": " << stones << " stones -> " << move_to_str(best) << endl;
+
+        cells[best] = toMove;
+        expand(cells, stones + 1, bookSide);
+        cells[best] = 0;
+        return;
+    }
+
+    // Replies that are mirror images of each other lead to the same entry.
+    set<uint64_t> replies;
+    for (int idx = 0; idx < BOARD_SIZE * BOARD_SIZE; idx++) {
+        if (cells[idx] != 0 || !nearStone(cells, idx, stones)) continue;
+        cells[idx] = toMove;
+        loadPosition(cells.data());
+        if (replies.insert(canonicalHash(sym)).second) expand(cells, stones + 1, bookSide);
+        cells[idx] = 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--plies") == 0) BOOK_PLIES = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--radius") == 0) BOOK_RADIUS = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0) outPath = argv[++i];
+    }
+    bookPath = nullptr;
+
+    initZobrist();
+    if (!initTT()) return 1;
+    initSearch();
+    ostringstream quiet;
+    searchLog = &quiet;
+
+    for (int side = 1; side <= 2; side++) {
+        vector<int> cells(BOARD_SIZE * BOARD_SIZE, 0);
+        expand(cells, 0, side);
+        quiet.str("");
+    }
+    if (!writeBook(outPath, entries)) return 1;
+    cerr << "wrote " << entries.size() << " positions to " << outPath << endl;
+    return 0;
+}
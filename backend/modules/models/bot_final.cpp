@@ -1,24 +1,20 @@
 #define LIB_MODE
 #include "bot_level_3.cpp"
 
-int main() {
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
     NOISE_MAGNITUDE = 20000; 
 
     DEFENSE_SCALE = 1.2; 
 
     initZobrist();
+    if (!initTT()) return 1;
+    initSearch();
     int move;
     while (cin >> move) {
-        if (move != -1) {
-            board[move] = opID;
-            toggleHash(move, opID);
-        } else {
-            myID = 1; opID = 2;
-        }
-        int best = solve();
-        board[best] = myID;
-        toggleHash(best, myID);
-        cout << best << endl;
+        cout << nextMove(move) << endl;
+        if (USE_PONDER) startPonder();
     }
+    finishPonder(-1);
     return 0;
 }
\ No newline at end of file
@@ -3,28 +3,28 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
-#include <climits>
-#include <set>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 
+#include "../logic/ZobristTable.cpp"
+#include "../logic/PatternMatcher.cpp"
+
 using namespace std;
 
-const int SIZE = 20;
+const int TIME_LIMIT_MS = 500;
 const int MAX_DEPTH = 3;
 const int NEIGHBOR_RADIUS = 2;
+const long long INF_SCORE = 1e16;
+const long long WIN_SCORE = 10000;
+const double DEFENSE_SCALE = 1.3;
 
 const int EMPTY = 0;
 const int OPPONENT = 1;
 const int BOT = 2;
 
-int board[SIZE * SIZE] = {0};
 long long nodesCount = 0;
-
-struct Pattern {
-    string s;
-    int score;
-};
+int timeLimitMs = TIME_LIMIT_MS;
 
 const vector<Pattern> PATTERNS = {
     {"XXXXX", 100000},
@@ -38,277 +38,226 @@ const vector<Pattern> PATTERNS = {
     {"_XX_", 50}
 };
 
-inline int get_idx(int x, int y) {
-    return y * SIZE + x;
-}
+const PatternMatcher patternMatcher(PATTERNS, BOARD_SIZE);
 
-inline bool is_valid(int x, int y) {
-    return x >= 0 && x < SIZE && y >= 0 && y < SIZE;
-}
+long long history[BOARD_SIZE * BOARD_SIZE];
+
+chrono::steady_clock::time_point startTime;
+bool timeOut;
 
 string move_to_str(int move) {
     if (move == -1) return "NULL";
-    int x = move % SIZE;
-    int y = move / SIZE;
+    int x = getX(move);
+    int y = getY(move);
     char col = 'A' + x;
     return string(1, col) + to_string(y + 1);
 }
 
-int count_occurrences(const string& str, const string& sub) {
-    int count = 0;
-    size_t pos = 0;
-    while ((pos = str.find(sub, pos)) != string::npos) {
-        count++;
-        pos += sub.length();
+// Pattern score of every line from the bot's side, and their sum; a move
+// only rescans the four lines through it.
+vector<long long> lineScore(patternMatcher.numLines(), 0);
+long long boardScore = 0;
+
+void updateLines(int idx) {
+    for (int d = 0; d < 4; d++) {
+        int line = patternMatcher.lineThrough(idx, d);
+        if (line < 0) continue;
+        long long score = 0;
+        patternMatcher.scanLine(line, board, BOT, OPPONENT, [&](const Pattern& p, int mine, int theirs) {
+            score += mine * p.score;
+            score -= theirs * p.score * DEFENSE_SCALE;
+        });
+        boardScore += score - lineScore[line];
+        lineScore[line] = score;
     }
-    return count;
 }
 
-string line_to_string(const vector<int>& line, int my_val, int op_val) {
-    string s = "";
-    s.reserve(line.size());
-    for (int val : line) {
-        if (val == my_val) s += 'X';
-        else if (val == op_val) s += 'O';
-        else s += '_';
-    }
-    return s;
-}
+// Empty cells within NEIGHBOR_RADIUS of a stone, kept as a set with O(1)
+// insert and erase.
+int neighborCount[BOARD_SIZE * BOARD_SIZE];
+int candList[BOARD_SIZE * BOARD_SIZE];
+int candPos[BOARD_SIZE * BOARD_SIZE];
+int candCount = 0;
 
-int quick_eval(int bot_val, int opp_val) {
-    int score = 0;
-    for (int i = 0; i < SIZE * SIZE; ++i) {
-        if (board[i] == bot_val) score += 3;
-        else if (board[i] == opp_val) score -= 4;
-    }
-    return score;
+inline void candAdd(int idx) {
+    candPos[idx] = candCount;
+    candList[candCount++] = idx;
 }
 
-int pattern_evaluate(int bot_val, int opp_val) {
-    vector<string> lines;
-    lines.reserve(SIZE * 2 + SIZE * 4);
-
-    for (int y = 0; y < SIZE; ++y) {
-        vector<int> row;
-        for (int x = 0; x < SIZE; ++x) row.push_back(board[get_idx(x, y)]);
-        lines.push_back(line_to_string(row, bot_val, opp_val));
-    }
-
-    for (int x = 0; x < SIZE; ++x) {
-        vector<int> col;
-        for (int y = 0; y < SIZE; ++y) col.push_back(board[get_idx(x, y)]);
-        lines.push_back(line_to_string(col, bot_val, opp_val));
-    }
-
-    for (int d = -(SIZE - 1); d < SIZE; ++d) {
-        vector<int> diag;
-        for (int y = 0; y < SIZE; ++y) {
-            int x = y - d;
-            if (is_valid(x, y)) diag.push_back(board[get_idx(x, y)]);
-        }
-        if (diag.size() >= 5) lines.push_back(line_to_string(diag, bot_val, opp_val));
-    }
-
-    for (int d = 0; d < SIZE * 2; ++d) {
-        vector<int> diag;
-        for (int y = 0; y < SIZE; ++y) {
-            int x = d - y;
-            if (is_valid(x, y)) diag.push_back(board[get_idx(x, y)]);
-        }
-        if (diag.size() >= 5) lines.push_back(line_to_string(diag, bot_val, opp_val));
-    }
-
-    long long total_score = 0;
-
-    for (const string& s : lines) {
-        for (const auto& p : PATTERNS) {
-            total_score += count_occurrences(s, p.s) * p.score;
-            
-            string p_opp = p.s;
-            replace(p_opp.begin(), p_opp.end(), 'X', 'K');
-            replace(p_opp.begin(), p_opp.end(), 'O', 'X');
-            replace(p_opp.begin(), p_opp.end(), 'K', 'O');
+inline void candRemove(int idx) {
+    int last = candList[--candCount];
+    candList[candPos[idx]] = last;
+    candPos[last] = candPos[idx];
+    candPos[idx] = -1;
+}
 
-            total_score -= count_occurrences(s, p_opp) * p.score * 1.3;
+void updateNeighbors(int idx, int delta) {
+    int x = getX(idx), y = getY(idx);
+    for (int dy = -NEIGHBOR_RADIUS; dy <= NEIGHBOR_RADIUS; ++dy) {
+        for (int dx = -NEIGHBOR_RADIUS; dx <= NEIGHBOR_RADIUS; ++dx) {
+            if ((dx == 0 && dy == 0) || !isValid(x + dx, y + dy)) continue;
+            int n = getIdx(x + dx, y + dy);
+            neighborCount[n] += delta;
+            if (delta > 0 && neighborCount[n] == 1 && board[n] == EMPTY) candAdd(n);
+            if (delta < 0 && neighborCount[n] == 0 && candPos[n] >= 0) candRemove(n);
         }
     }
+}
 
-    return (int)total_score;
+void makeMove(int idx, int p) {
+    board[idx] = p;
+    toggleHash(idx, p);
+    updateLines(idx);
+    if (candPos[idx] >= 0) candRemove(idx);
+    updateNeighbors(idx, 1);
 }
 
-vector<int> get_neighboring_cells() {
-    set<int> candidates;
-    vector<int> occupied;
-    
-    for(int i=0; i<SIZE*SIZE; ++i) {
-        if(board[i] != EMPTY) occupied.push_back(i);
-    }
+void unmakeMove(int idx, int p) {
+    board[idx] = EMPTY;
+    toggleHash(idx, p);
+    updateLines(idx);
+    updateNeighbors(idx, -1);
+    if (neighborCount[idx] > 0) candAdd(idx);
+}
 
-    if (occupied.empty()) return {};
-
-    for (int idx : occupied) {
-        int ox = idx % SIZE;
-        int oy = idx / SIZE;
-        
-        for (int dy = -NEIGHBOR_RADIUS; dy <= NEIGHBOR_RADIUS; ++dy) {
-            for (int dx = -NEIGHBOR_RADIUS; dx <= NEIGHBOR_RADIUS; ++dx) {
-                if (dx == 0 && dy == 0) continue;
-                int nx = ox + dx;
-                int ny = oy + dy;
-                if (is_valid(nx, ny)) {
-                    int n_idx = get_idx(nx, ny);
-                    if (board[n_idx] == EMPTY) {
-                        candidates.insert(n_idx);
-                    }
-                }
-            }
-        }
-    }
-    return vector<int>(candidates.begin(), candidates.end());
+void resetBoard() {
+    memset(board, 0, sizeof(board));
+    memset(neighborCount, 0, sizeof(neighborCount));
+    memset(candPos, -1, sizeof(candPos));
+    candCount = 0;
+    fill(lineScore.begin(), lineScore.end(), 0);
+    boardScore = 0;
+    resetHash();
 }
 
-vector<int> move_ordering(const vector<int>& candidates, int player) {
-    int opp = (player == BOT) ? OPPONENT : BOT;
-    vector<pair<int, int>> scored_moves;
-    
-    for (int idx : candidates) {
-        board[idx] = player;
-        int s = quick_eval(player, opp);
-        board[idx] = EMPTY;
-        scored_moves.push_back({s, idx});
-    }
+inline long long evaluate(int p) {
+    return p == BOT ? boardScore : -boardScore;
+}
 
-    sort(scored_moves.begin(), scored_moves.end(), [](const pair<int,int>& a, const pair<int,int>& b) {
-        return a.first > b.first;
+vector<int> orderedMoves(int hashMove) {
+    vector<int> moves(candList, candList + candCount);
+    sort(moves.begin(), moves.end(), [&](int a, int b) {
+        if (a == hashMove || b == hashMove) return a == hashMove && b != hashMove;
+        if (history[a] != history[b]) return history[a] > history[b];
+        return a < b;
     });
-
-    vector<int> result;
-    for (auto& p : scored_moves) result.push_back(p.second);
-    return result;
+    return moves;
 }
 
-int minimax(int depth, int alpha, int beta, bool maximizing, int bot_val, int opp_val) {
+long long negamax(int depth, long long alpha, long long beta, int p) {
     nodesCount++;
-    int score = pattern_evaluate(bot_val, opp_val);
+    if ((nodesCount & 1023) == 0 && chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > timeLimitMs) {
+        timeOut = true;
+    }
+    if (timeOut) return 0;
 
-    if (abs(score) >= 10000 || depth == 0) {
-        return score;
+    if (abs(boardScore) >= WIN_SCORE || depth == 0 || candCount == 0) return evaluate(p);
+
+    TTEntry tt;
+    bool ttHit = ttProbePosition(tt);
+    if (ttHit && tt.depth >= depth) {
+        if (tt.flag == FLAG_EXACT) return tt.score;
+        if (tt.flag == FLAG_LOWERBOUND && tt.score >= beta) return beta;
+        if (tt.flag == FLAG_UPPERBOUND && tt.score <= alpha) return alpha;
     }
 
-    vector<int> candidates = get_neighboring_cells();
-    if (candidates.empty()) return score;
-
-    if (maximizing) {
-        vector<int> moves = move_ordering(candidates, bot_val);
-        int max_eval = -INT_MAX;
-        for (int idx : moves) {
-            board[idx] = bot_val;
-            int eval = minimax(depth - 1, alpha, beta, false, bot_val, opp_val);
-            board[idx] = EMPTY;
-            
-            max_eval = max(max_eval, eval);
-            alpha = max(alpha, eval);
-            if (beta <= alpha) break;
+    long long bestVal = -INF_SCORE;
+    int bestMove = -1;
+    int flag = FLAG_UPPERBOUND;
+    int op = (p == BOT) ? OPPONENT : BOT;
+
+    for (int m : orderedMoves(ttHit ? tt.bestMove : -1)) {
+        makeMove(m, p);
+        long long val = -negamax(depth - 1, -beta, -alpha, op);
+        unmakeMove(m, p);
+        if (timeOut) return 0;
+        if (val > bestVal) {
+            bestVal = val;
+            bestMove = m;
+        }
+        if (bestVal > alpha) {
+            alpha = bestVal;
+            flag = FLAG_EXACT;
         }
-        return max_eval;
-    } else {
-        vector<int> moves = move_ordering(candidates, opp_val);
-        int min_eval = INT_MAX;
-        for (int idx : moves) {
-            board[idx] = opp_val;
-            int eval = minimax(depth - 1, alpha, beta, true, bot_val, opp_val);
-            board[idx] = EMPTY;
-            
-            min_eval = min(min_eval, eval);
-            beta = min(beta, eval);
-            if (beta <= alpha) break;
+        if (alpha >= beta) {
+            flag = FLAG_LOWERBOUND;
+            history[m] += depth * depth;
+            break;
         }
-        return min_eval;
     }
+    ttStorePosition(depth, bestVal, flag, bestMove);
+    return bestVal;
 }
 
 int find_best_move() {
-    auto startTime = chrono::steady_clock::now();
+    startTime = chrono::steady_clock::now();
+    timeOut = false;
     nodesCount = 0;
+    ttNewSearch();
+    memset(history, 0, sizeof(history));
 
-    vector<int> candidates = get_neighboring_cells();
-    
-    if (candidates.empty()) {
-        int center = SIZE / 2;
-        if (board[get_idx(center, center)] == EMPTY) return get_idx(center, center);
-        return -1; 
+    if (candCount == 0) {
+        int center = getIdx(BOARD_SIZE / 2, BOARD_SIZE / 2);
+        return board[center] == EMPTY ? center : -1;
     }
 
-    vector<int> ordered_moves = move_ordering(candidates, BOT);
-    int best_move = ordered_moves[0];
-    int best_score = -INT_MAX;
-    int alpha = -INT_MAX;
-    int beta = INT_MAX;
-
-    for (int idx : ordered_moves) {
-        board[idx] = BOT;
-        int score = minimax(MAX_DEPTH - 1, alpha, beta, false, BOT, OPPONENT);
-        board[idx] = EMPTY;
-
-        if (score > best_score) {
-            best_score = score;
-            best_move = idx;
+    int bestMove = candList[0];
+    for (int d = 1; d <= MAX_DEPTH; d++) {
+        long long bestVal = -INF_SCORE;
+        long long alpha = -INF_SCORE;
+        int curMove = -1;
+        for (int m : orderedMoves(bestMove)) {
+            makeMove(m, BOT);
+            long long val = -negamax(d - 1, -INF_SCORE, -alpha, OPPONENT);
+            unmakeMove(m, BOT);
+            if (timeOut) break;
+            if (val > bestVal) {
+                bestVal = val;
+                curMove = m;
+            }
+            alpha = max(alpha, bestVal);
         }
-        
-        alpha = max(alpha, score);
-        if (beta <= alpha) break;
-    }
 
-    auto now = chrono::steady_clock::now();
-    auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - startTime).count();
-    
-    int d = MAX_DEPTH;
-    int bestVal = best_score;
-    int bestMove = best_move;
-    bool timeOut = false;
-    int curMove = bestMove;
-
-    if (!timeOut && curMove != -1) {
-        bestMove = curMove;
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+        if (!timeOut && curMove != -1) bestMove = curMove;
         cerr << "depth:" << d
             << ",  eval:" << bestVal
             << ",  nodes:" << nodesCount
             << ",  time:" << elapsed << "ms"
             << ",  best:" << move_to_str(bestMove)
+            << (timeOut ? "  [TIMEOUT]" : "")
             << endl;
-    } else {
-        cerr << "depth:" << d
-            << ",  eval:" << bestVal
-            << ",  nodes:" << nodesCount
-            << ",  time:" << elapsed << "ms"
-            << ",  best:" << move_to_str(bestMove)
-            << "  [TIMEOUT]"
-            << endl;
+        if (timeOut || bestVal >= WIN_SCORE) break;
     }
 
     cerr << "bestmove " << move_to_str(bestMove) << endl;
+    return bestMove;
+}
 
-    return best_move;
+void parseArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (parseTTOption(argv[i], argv[i + 1])) i++;
+        else if (strcmp(argv[i], "--time") == 0) timeLimitMs = atoi(argv[++i]);
+    }
 }
 
-int main() {
+int main(int argc, char** argv) {
     setbuf(stderr, NULL);
     ios_base::sync_with_stdio(false);
     cin.tie(NULL);
+    parseArgs(argc, argv);
+    initZobrist();
+    if (!initTT()) return 1;
+    resetBoard();
 
     int op_move;
     while (cin >> op_move) {
-        if (op_move != -1) {
-            board[op_move] = OPPONENT;
-        }
+        if (op_move != -1) makeMove(op_move, OPPONENT);
 
         int my_move = find_best_move();
-        
-        if (my_move != -1) {
-            board[my_move] = BOT;
-        }
-        
+        if (my_move != -1) makeMove(my_move, BOT);
+
         cout << my_move << endl;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -9,6 +9,8 @@
 #include <iomanip>
 
 #include "../logic/ZobristTable.cpp"
+#include "../logic/SearchInfo.h"
+#include "../logic/PatternMatcher.cpp"
 
 using namespace std;
 
@@ -20,11 +22,10 @@ const long long INF_SCORE = 1e16;
 double DEFENSE_SCALE = 1.3;
 int NOISE_MAGNITUDE = 0;
 long long nodesCount = 0;
-
-struct Pattern {
-    string s;
-    int score;
-};
+int timeLimitMs = TIME_LIMIT_MS;
+int depthLimit = MAX_SEARCH_DEPTH;
+long long nodeLimit = 0;
+SearchInfo searchInfo;
 
 const vector<Pattern> PATTERNS = {
     {"XXXXX", 100000},
@@ -38,6 +39,8 @@ const vector<Pattern> PATTERNS = {
     {"_XX_", 50}
 };
 
+const PatternMatcher patternMatcher(PATTERNS, BOARD_SIZE);
+
 int myID = 2;
 int opID = 1;
 
@@ -56,74 +59,13 @@ string move_to_str(int move) {
     return string(1, col) + to_string(y + 1);
 }
 
-int count_occurrences(const string& str, const string& sub) {
-    int count = 0;
-    size_t pos = 0;
-    while ((pos = str.find(sub, pos)) != string::npos) {
-        count++;
-        pos += sub.length();
-    }
-    return count;
-}
-
-string line_to_string(const vector<int>& line, int my_val, int op_val) {
-    string s = "";
-    s.reserve(line.size());
-    for (int val : line) {
-        if (val == my_val) s += 'X';
-        else if (val == op_val) s += 'O';
-        else s += '_';
-    }
-    return s;
-}
-
 long long pattern_evaluate(int bot_val) {
     int opp_val = (bot_val == 1) ? 2 : 1;
-    vector<string> lines;
-    lines.reserve(BOARD_SIZE * 2 + BOARD_SIZE * 4);
-
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        vector<int> row;
-        for (int x = 0; x < BOARD_SIZE; ++x) row.push_back(board[getIdx(x, y)]);
-        lines.push_back(line_to_string(row, bot_val, opp_val));
-    }
-
-    for (int x = 0; x < BOARD_SIZE; ++x) {
-        vector<int> col;
-        for (int y = 0; y < BOARD_SIZE; ++y) col.push_back(board[getIdx(x, y)]);
-        lines.push_back(line_to_string(col, bot_val, opp_val));
-    }
-
-    for (int d = -(BOARD_SIZE - 1); d < BOARD_SIZE; ++d) {
-        vector<int> diag;
-        for (int y = 0; y < BOARD_SIZE; ++y) {
-            int x = y - d;
-            if (isValid(x, y)) diag.push_back(board[getIdx(x, y)]);
-        }
-        if (diag.size() >= 5) lines.push_back(line_to_string(diag, bot_val, opp_val));
-    }
-
-    for (int d = 0; d < BOARD_SIZE * 2; ++d) {
-        vector<int> diag;
-        for (int y = 0; y < BOARD_SIZE; ++y) {
-            int x = d - y;
-            if (isValid(x, y)) diag.push_back(board[getIdx(x, y)]);
-        }
-        if (diag.size() >= 5) lines.push_back(line_to_string(diag, bot_val, opp_val));
-    }
-
     long long total_score = 0;
-
-    for (const string& s : lines) {
-        for (const auto& p : PATTERNS) {
-            total_score += count_occurrences(s, p.s) * p.score;
-            string p_opp = p.s;
-            replace(p_opp.begin(), p_opp.end(), 'X', 'K');
-            replace(p_opp.begin(), p_opp.end(), 'O', 'X');
-            replace(p_opp.begin(), p_opp.end(), 'K', 'O');
-            total_score -= count_occurrences(s, p_opp) * p.score * DEFENSE_SCALE;
-        }
-    }
+    patternMatcher.scan(board, bot_val, opp_val, [&](const Pattern& p, int mine, int theirs) {
+        total_score += mine * p.score;
+        total_score -= theirs * p.score * DEFENSE_SCALE;
+    });
 
     if (NOISE_MAGNITUDE > 0) {
         total_score += (long long)(rng() % (NOISE_MAGNITUDE * 2 + 1)) - NOISE_MAGNITUDE;
@@ -178,15 +120,17 @@ vector<int> generateMoves() {
 
 long long alphaBeta(int depth, long long alpha, long long beta, int p) {
     nodesCount++;
-    if ((depth % 4 == 0) && chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > TIME_LIMIT_MS) {
+    if ((nodeLimit && nodesCount >= nodeLimit)
+        || ((depth % 4 == 0) && chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > timeLimitMs)) {
         timeOut = true;
         return 0;
     }
-    int idx = currentHash & (TT_TABLE_SIZE - 1);
-    if (TTable[idx].key == currentHash && TTable[idx].depth >= depth) {
-        if (TTable[idx].flag == FLAG_EXACT) return TTable[idx].score;
-        if (TTable[idx].flag == FLAG_LOWERBOUND && TTable[idx].score >= beta) return beta;
-        if (TTable[idx].flag == FLAG_UPPERBOUND && TTable[idx].score <= alpha) return alpha;
+    TTEntry tt;
+    bool ttHit = ttProbePosition(tt);
+    if (ttHit && tt.depth >= depth) {
+        if (tt.flag == FLAG_EXACT) return tt.score;
+        if (tt.flag == FLAG_LOWERBOUND && tt.score >= beta) return beta;
+        if (tt.flag == FLAG_UPPERBOUND && tt.score <= alpha) return alpha;
     }
     if (depth == 0) return pattern_evaluate(p);
 
@@ -194,7 +138,7 @@ long long alphaBeta(int depth, long long alpha, long long beta, int p) {
     if (moves.empty()) return 0;
 
     int bestMoveCache = -1;
-    if (TTable[idx].key == currentHash) bestMoveCache = TTable[idx].bestMove;
+    if (ttHit) bestMoveCache = tt.bestMove;
 
     for (int& m : moves) {
         long long score = 0;
@@ -243,27 +187,29 @@ long long alphaBeta(int depth, long long alpha, long long beta, int p) {
             break;
         }
     }
-    if (!timeOut) TTable[idx] = {currentHash, depth, bestVal, flag, moveIdx};
+    if (!timeOut) ttStorePosition(depth, bestVal, flag, moveIdx);
     return bestVal;
 }
 
 int solve() {
     startTime = chrono::steady_clock::now();
     timeOut = false;
+    ttNewSearch();
     nodesCount = 0;
+    searchInfo.reset();
     memset(history, 0, sizeof(history));
     memset(killerMoves, 0, sizeof(killerMoves));
     vector<int> moves = generateMoves();
     if (moves.size() == 1) return moves[0];
     int bestMove = moves[0];
     
-    for (int d = 1; d <= MAX_SEARCH_DEPTH; d++) {
+    for (int d = 1; d <= depthLimit; d++) {
         long long bestVal = -INF_SCORE * 2;
         int curMove = -1;
         long long alpha = -INF_SCORE * 2;
         long long beta = INF_SCORE * 2;
-        int idx = currentHash & (TT_TABLE_SIZE - 1);
-        if (TTable[idx].key == currentHash && TTable[idx].bestMove != -1) bestMove = TTable[idx].bestMove;
+        TTEntry tt;
+        if (ttProbePosition(tt) && tt.bestMove != -1) bestMove = tt.bestMove;
         
         sort(moves.begin(), moves.end(), [&](int a, int b) {
             if (a == bestMove) return true;
@@ -291,6 +237,9 @@ int solve() {
 
         if (!timeOut && curMove != -1) {
             bestMove = curMove;
+            searchInfo.depth = d;
+            searchInfo.score = bestVal;
+            searchInfo.depthMs.push_back(elapsed);
 
             cerr << "depth:" << d
                 << ",  eval:" << bestVal
@@ -314,15 +263,25 @@ int solve() {
 
 
             }
+            searchInfo.bestMove = bestMove;
+            searchInfo.nodes = nodesCount;
             cerr << "bestmove " << move_to_str(bestMove) << endl;
             return bestMove;
         }
 
+void parseArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (parseTTOption(argv[i], argv[i + 1])) i++;
+    }
+}
+
 #ifndef LIB_MODE
-int main() {
+int main(int argc, char** argv) {
     setbuf(stderr, NULL); 
     cerr << "system: Bot Level 2 Initialized..." << endl;
+    parseArgs(argc, argv);
     initZobrist();
+    if (!initTT()) return 1;
     int move;
     while (cin >> move) {
         if (move != -1) {
@@ -6,7 +6,14 @@
 #include <cmath>
 #include <random>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <sstream>
 #include "../logic/ZobristTable.cpp"
+#include "../logic/BitBoard.cpp"
+#include "../logic/SearchInfo.h"
+#include "../logic/OpeningBook.cpp"
 
 using namespace std;
 
@@ -16,8 +23,17 @@ double DEFENSE_SCALE = 1.1;
 const int TIME_LIMIT_MS = 1000;
 const int VCT_TIME_LIMIT_MS = 200;
 const int MAX_SEARCH_DEPTH = 20;
-const int VCT_DEPTH = 12;
-const int MOVE_GEN_RADIUS = 2;
+const int VCT_DEPTH = 20;
+const int MIN_MOVE_MS = 10;
+const long long ASPIRATION_WINDOW = 3e7;
+const int DFPN_TABLE_BITS = 20;
+const int DFPN_MAX_PLY = 64;
+const uint32_t DFPN_INF = 1u << 30;
+const int THREAT_CACHE_BITS = 20;
+const int HISTORY_AGE_SHIFT = 2;
+const int LMR_MIN_DEPTH = 3;
+const int LMR_MIN_MOVES = 3;
+const int LMR_LATE_MOVES = 10;
 
 const long long INF_SCORE = 1e16;
 const long long SCORE_WIN = 1e14;
@@ -28,6 +44,15 @@ const long long SCORE_DEAD_3 = 2e6;
 const long long SCORE_LIVE_2 = 2e6;
 const long long SCORE_DEAD_2 = 1e4;
 
+// Score of a run of fewer than five stones by its number of open ends.
+const long long RUN_SCORE[5][3] = {
+    {0, 0, 0},
+    {0, 0, 0},
+    {0, SCORE_DEAD_2, SCORE_LIVE_2},
+    {0, SCORE_DEAD_3, SCORE_LIVE_3},
+    {0, SCORE_DEAD_4, SCORE_LIVE_4},
+};
+
 const int TYPE_NONE = 0;
 const int TYPE_DEAD_3 = 1;
 const int TYPE_OPEN_3 = 2;
@@ -35,16 +60,54 @@ const int TYPE_CLOSED_4 = 3;
 const int TYPE_OPEN_4 = 4;
 const int TYPE_WIN = 5;
 
-int myID = 2;
-int opID = 1;
-
-long long history[BOARD_SIZE * BOARD_SIZE];
-long long killerMoves[MAX_SEARCH_DEPTH][2];
-long long nodesCount = 0;
-
-chrono::steady_clock::time_point startTime;
-bool timeOut;
-mt19937 rng(chrono::steady_clock::now().time_since_epoch().count());
+// A window is the 8 cells within 4 steps of a cell along one direction,
+// one base-3 digit each from the view of one player.
+const int WINDOW_REACH = 4;
+const int WINDOW_CODES = 6561;
+const int CELL_EMPTY = 0;
+const int CELL_OWN = 1;
+const int CELL_BLOCKED = 2;
+
+int SEARCH_THREADS = 1;
+bool USE_DFPN = false;
+bool USE_THREAT_PASS = true;
+bool USE_PONDER = false;
+const char* bookPath = nullptr;
+int timeLimitMs = TIME_LIMIT_MS;
+int depthLimit = MAX_SEARCH_DEPTH;
+long long nodeLimit = 0;
+
+// State one solve() shares with its Lazy SMP helpers.
+struct SharedSearch {
+    atomic<bool> stop{false};
+    atomic<long long> nodes{0};
+    bool pondering = false;
+    long long hardLimitMs = 0;
+};
+
+// Search state is per thread; only the transposition table is shared.
+thread_local int myID = 2;
+thread_local int opID = 1;
+thread_local long long history[BOARD_SIZE * BOARD_SIZE];
+thread_local long long killerMoves[MAX_SEARCH_DEPTH][2];
+thread_local long long nodesCount = 0;
+
+thread_local chrono::steady_clock::time_point startTime;
+thread_local bool timeOut;
+thread_local bool pondering = false;
+thread_local int searchPly = 0;
+thread_local int selDepth = 0;
+thread_local long long hardLimitMs = TIME_LIMIT_MS;
+thread_local int threatLimitMs = VCT_TIME_LIMIT_MS;
+
+// Time control of the side to move: the game clock left (0 when the game is
+// untimed) and a per-move budget that overrides timeLimitMs (0 when unset).
+thread_local long long clockMs = 0;
+thread_local long long moveBudgetMs = 0;
+thread_local SharedSearch* sharedSearch = nullptr;
+thread_local ostream* searchLog = &cerr;
+thread_local SearchInfo searchInfo;
+thread_local mt19937 rng(chrono::steady_clock::now().time_since_epoch().count());
 
 string move_to_str(int move) {
     if (move == -1) return "NULL";
@@ -54,165 +117,317 @@ string move_to_str(int move) {
     return string(1, col) + to_string(y + 1);
 }
 
-int getMoveStatus(int idx, int p) {
-    int cx = getX(idx);
-    int cy = getY(idx);
-    int maxStatus = TYPE_NONE;
-    int dirs[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
-
-    for (int d = 0; d < 4; d++) {
-        int dx = dirs[d][0];
-        int dy = dirs[d][1];
-
-        int count = 1;
+// windowCode[q][c][d] encodes the window around c for player q + 1: empty,
+// own stone, or blocked (opponent stone or off the board). Every move
+// updates the windows of the cells it falls in, so the status of playing c
+// in direction d is a single table load.
+int windowPow[2 * WINDOW_REACH + 1];
+uint8_t windowStatus[WINDOW_CODES];
+uint16_t wallCode[BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+thread_local uint16_t windowCode[2][BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+
+// Digit weight of the cell k steps from the center (k != 0).
+inline int windowDigit(int k) { return windowPow[k + WINDOW_REACH]; }
+
+void initWindows() {
+    for (int k = -WINDOW_REACH, w = 1; k <= WINDOW_REACH; k++) {
+        windowPow[k + WINDOW_REACH] = k == 0 ? 0 : w;
+        if (k != 0) w *= 3;
+    }
 
-        int x = cx + dx, y = cy + dy;
-        while (isValid(x, y) && board[getIdx(x, y)] == p) {
-            count++;
-            x += dx; y += dy;
-        }
-        bool openPos = isValid(x, y) && board[getIdx(x, y)] == 0;
+    // The status of playing the center: the run it joins and its open ends.
+    for (int code = 0; code < WINDOW_CODES; code++) {
+        auto cell = [&](int k) { return code / windowDigit(k) % 3; };
+        int up = 0, down = 0;
+        while (up < WINDOW_REACH && cell(up + 1) == CELL_OWN) up++;
+        while (down < WINDOW_REACH && cell(-down - 1) == CELL_OWN) down++;
+        int count = up + down + 1;
+        int openEnds = (up < WINDOW_REACH && cell(up + 1) == CELL_EMPTY)
+                     + (down < WINDOW_REACH && cell(-down - 1) == CELL_EMPTY);
+
+        int status = TYPE_NONE;
+        if (count >= 5) status = TYPE_WIN;
+        else if (count == 4 && openEnds > 0) status = openEnds == 2 ? TYPE_OPEN_4 : TYPE_CLOSED_4;
+        else if (count == 3 && openEnds > 0) status = openEnds == 2 ? TYPE_OPEN_3 : TYPE_DEAD_3;
+        windowStatus[code] = status;
+    }
 
-        x = cx - dx; y = cy - dy;
-        while (isValid(x, y) && board[getIdx(x, y)] == p) {
-            count++;
-            x -= dx; y -= dy;
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        for (int d = 0; d < NUM_DIRS; d++) {
+            int pos = cellPos[i][d];
+            int len = lineLen[cellLine[i][d]];
+            wallCode[i][d] = 0;
+            for (int k = -WINDOW_REACH; k <= WINDOW_REACH; k++) {
+                if (pos + k < 0 || pos + k >= len) wallCode[i][d] += CELL_BLOCKED * windowDigit(k);
+            }
         }
-        bool openNeg = isValid(x, y) && board[getIdx(x, y)] == 0;
-
-        int openEnds = (openPos ? 1 : 0) + (openNeg ? 1 : 0);
-
-        if (count >= 5) return TYPE_WIN;
+    }
+}
 
-        if (count == 4) {
-            if (openEnds == 2) return TYPE_OPEN_4;
-            if (openEnds == 1) maxStatus = max(maxStatus, TYPE_CLOSED_4);
-        }
+void resetWindows() {
+    for (int q = 0; q < 2; q++) memcpy(windowCode[q], wallCode, sizeof(wallCode));
+}
 
-        if (count == 3) {
-            if (openEnds == 2) maxStatus = max(maxStatus, TYPE_OPEN_3);
-            else if (openEnds == 1) maxStatus = max(maxStatus, TYPE_DEAD_3);
+// sign is 1 when the stone of p at idx is placed and -1 when it is removed.
+void updateWindows(int idx, int p, int sign) {
+    uint16_t (*own)[NUM_DIRS] = windowCode[p - 1];
+    uint16_t (*other)[NUM_DIRS] = windowCode[2 - p];
+    for (int d = 0; d < NUM_DIRS; d++) {
+        int pos = cellPos[idx][d];
+        int len = lineLen[cellLine[idx][d]];
+        int step = DIR_STEP[d];
+        for (int k = max(-WINDOW_REACH, -pos); k <= min(WINDOW_REACH, len - 1 - pos); k++) {
+            if (k == 0) continue;
+            // idx lies -k steps from the cell k steps away.
+            int c = idx + k * step, w = sign * windowDigit(-k);
+            own[c][d] += CELL_OWN * w;
+            other[c][d] += CELL_BLOCKED * w;
         }
     }
+}
+
+inline int dirMoveStatus(int idx, int d, int p) {
+    return windowStatus[windowCode[p - 1][idx][d]];
+}
+
+int getMoveStatus(int idx, int p) {
+    int maxStatus = TYPE_NONE;
+    for (int d = 0; d < NUM_DIRS; d++) maxStatus = max(maxStatus, dirMoveStatus(idx, d, p));
     return maxStatus;
 }
 
-long long evaluateLine(const vector<int>& line, int p) {
-    long long score = 0;
-    int n = (int)line.size();
+thread_local long long lineScore[NUM_LINES][2];
+thread_local long long lineScoreSum[2];
+thread_local int winLines[2];
 
-    for (int i = 0; i < n; ) {
-        if (line[i] != p) { i++; continue; }
+void resetEvalLines() {
+    memset(lineScore, 0, sizeof(lineScore));
+    memset(lineScoreSum, 0, sizeof(lineScoreSum));
+    memset(winLines, 0, sizeof(winLines));
+}
 
-        int start = i;
-        while (i < n && line[i] == p) i++;
-        int count = i - start;
+long long evaluateLine(int line, int p) {
+    long long score = 0;
+    uint32_t m = lineBits[p - 1][line];
+    uint64_t e = emptyBits(line);
 
-        int openEnds = 0;
-        if (start - 1 >= 0 && line[start - 1] == 0) openEnds++;
-        if (i < n && line[i] == 0) openEnds++;
+    while (m) {
+        int start = __builtin_ctz(m);
+        int count = __builtin_ctz(~(m >> start));
+        int end = start + count;
+        m &= ~0u << end;
 
         if (count >= 5) return INF_SCORE;
-        if (count == 4) {
-            if (openEnds == 2) score += SCORE_LIVE_4;
-            else if (openEnds == 1) score += SCORE_DEAD_4;
-        } else if (count == 3) {
-            if (openEnds == 2) score += SCORE_LIVE_3;
-            else if (openEnds == 1) score += SCORE_DEAD_3;
-        } else if (count == 2) {
-            if (openEnds == 2) score += SCORE_LIVE_2;
-            else if (openEnds == 1) score += SCORE_DEAD_2;
-        }
+        int openEnds = ((e << 1) >> start & 1) + (e >> end & 1);
+        score += RUN_SCORE[count][openEnds];
     }
 
     return score;
 }
 
-long long evaluateBoard(int p) {
-    long long totalScore = 0;
-    int op = (p == 1) ? 2 : 1;
-
-    for (int y = 0; y < BOARD_SIZE; y++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int x = 0; x < BOARD_SIZE; x++) line.push_back(board[getIdx(x, y)]);
-        long long sp = evaluateLine(line, p);
-        if (sp >= SCORE_WIN) return INF_SCORE;
-        long long so = evaluateLine(line, op);
-        if (so >= SCORE_WIN) return -INF_SCORE;
-        totalScore += sp;
-        totalScore -= so * DEFENSE_SCALE;
-    }
-
-    for (int x = 0; x < BOARD_SIZE; x++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int y = 0; y < BOARD_SIZE; y++) line.push_back(board[getIdx(x, y)]);
-        long long sp = evaluateLine(line, p);
-        if (sp >= SCORE_WIN) return INF_SCORE;
-        long long so = evaluateLine(line, op);
-        if (so >= SCORE_WIN) return -INF_SCORE;
-        totalScore += sp;
-        totalScore -= so * DEFENSE_SCALE;
-    }
-
-    for (int k = 0; k < BOARD_SIZE; k++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int x = k, y = 0; x < BOARD_SIZE && y < BOARD_SIZE; x++, y++)
-            line.push_back(board[getIdx(x, y)]);
-        if (line.size() >= 5) {
-            long long sp = evaluateLine(line, p);
-            if (sp >= SCORE_WIN) return INF_SCORE;
-            long long so = evaluateLine(line, op);
-            if (so >= SCORE_WIN) return -INF_SCORE;
-            totalScore += sp;
-            totalScore -= so * DEFENSE_SCALE;
+void updateLines(int idx) {
+    for (int d = 0; d < NUM_DIRS; d++) {
+        int line = cellLine[idx][d];
+        if (lineLen[line] < 5) continue;
+        for (int q = 0; q < 2; q++) {
+            long long old = lineScore[line][q];
+            if (old >= SCORE_WIN) winLines[q]--;
+            else lineScoreSum[q] -= old;
+
+            long long cur = evaluateLine(line, q + 1);
+            lineScore[line][q] = cur;
+            if (cur >= SCORE_WIN) winLines[q]++;
+            else lineScoreSum[q] += cur;
         }
     }
-    for (int k = 1; k < BOARD_SIZE; k++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int x = 0, y = k; x < BOARD_SIZE && y < BOARD_SIZE; x++, y++)
-            line.push_back(board[getIdx(x, y)]);
-        if (line.size() >= 5) {
-            long long sp = evaluateLine(line, p);
-            if (sp >= SCORE_WIN) return INF_SCORE;
-            long long so = evaluateLine(line, op);
-            if (so >= SCORE_WIN) return -INF_SCORE;
-            totalScore += sp;
-            totalScore -= so * DEFENSE_SCALE;
+}
+
+int neighbors[BOARD_SIZE * BOARD_SIZE][8];
+int numNeighbors[BOARD_SIZE * BOARD_SIZE];
+thread_local int neighborCount[BOARD_SIZE * BOARD_SIZE];
+thread_local int candList[BOARD_SIZE * BOARD_SIZE];
+thread_local int candPos[BOARD_SIZE * BOARD_SIZE];
+thread_local int candCount = 0;
+
+void resetCandidates() {
+    memset(neighborCount, 0, sizeof(neighborCount));
+    memset(candPos, -1, sizeof(candPos));
+    candCount = 0;
+}
+
+void initCandidates() {
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        numNeighbors[i] = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dx == 0 && dy == 0) continue;
+                int nx = getX(i) + dx, ny = getY(i) + dy;
+                if (isValid(nx, ny)) neighbors[i][numNeighbors[i]++] = getIdx(nx, ny);
+            }
         }
     }
+}
 
-    for (int k = 0; k < BOARD_SIZE; k++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int x = k, y = 0; x >= 0 && y < BOARD_SIZE; x--, y++)
-            line.push_back(board[getIdx(x, y)]);
-        if (line.size() >= 5) {
-            long long sp = evaluateLine(line, p);
-            if (sp >= SCORE_WIN) return INF_SCORE;
-            long long so = evaluateLine(line, op);
-            if (so >= SCORE_WIN) return -INF_SCORE;
-            totalScore += sp;
-            totalScore -= so * DEFENSE_SCALE;
+inline void candAdd(int idx) {
+    candPos[idx] = candCount;
+    candList[candCount++] = idx;
+}
+
+inline void candRemove(int idx) {
+    int last = candList[--candCount];
+    candList[candPos[idx]] = last;
+    candPos[last] = candPos[idx];
+    candPos[idx] = -1;
+}
+
+// getMoveStatus of every empty cell for both players, per direction and
+// combined, refreshed along the four lines through each move. Cells worth at
+// least a three are kept in threatList, and statusCount counts cells per
+// status, so the threat solvers never rescan the board.
+thread_local uint8_t dirStatus[2][BOARD_SIZE * BOARD_SIZE][NUM_DIRS];
+thread_local uint8_t cellStatus[2][BOARD_SIZE * BOARD_SIZE];
+thread_local int threatList[2][BOARD_SIZE * BOARD_SIZE];
+thread_local int threatPos[2][BOARD_SIZE * BOARD_SIZE];
+thread_local int threatCount[2];
+thread_local int statusCount[2][TYPE_WIN + 1];
+
+void resetThreats() {
+    memset(dirStatus, 0, sizeof(dirStatus));
+    memset(cellStatus, 0, sizeof(cellStatus));
+    memset(threatPos, -1, sizeof(threatPos));
+    memset(threatCount, 0, sizeof(threatCount));
+    memset(statusCount, 0, sizeof(statusCount));
+}
+
+void setCellStatus(int q, int idx, int status) {
+    int old = cellStatus[q][idx];
+    if (old == status) return;
+    cellStatus[q][idx] = status;
+    statusCount[q][old]--;
+    statusCount[q][status]++;
+
+    if (old < TYPE_DEAD_3) {
+        threatPos[q][idx] = threatCount[q];
+        threatList[q][threatCount[q]++] = idx;
+    } else if (status < TYPE_DEAD_3) {
+        int last = threatList[q][--threatCount[q]];
+        threatList[q][threatPos[q][idx]] = last;
+        threatPos[q][last] = threatPos[q][idx];
+        threatPos[q][idx] = -1;
+    }
+}
+
+inline void refreshStatus(int q, int c, int d) {
+    uint8_t* ds = dirStatus[q][c];
+    ds[d] = dirMoveStatus(c, d, q + 1);
+    setCellStatus(q, c, max(max(ds[0], ds[1]), max(ds[2], ds[3])));
+}
+
+// A move only changes the status of empty cells that reach it through a run
+// of one player's stones; four such stones already make a win either way.
+void updateThreats(int idx) {
+    for (int q = 0; q < 2; q++) {
+        if (board[idx] != 0) {
+            memset(dirStatus[q][idx], 0, NUM_DIRS);
+            setCellStatus(q, idx, TYPE_NONE);
         }
     }
-    for (int k = 1; k < BOARD_SIZE; k++) {
-        vector<int> line;
-        line.reserve(BOARD_SIZE);
-        for (int x = BOARD_SIZE - 1, y = k; x >= 0 && y < BOARD_SIZE; x--, y++)
-            line.push_back(board[getIdx(x, y)]);
-        if (line.size() >= 5) {
-            long long sp = evaluateLine(line, p);
-            if (sp >= SCORE_WIN) return INF_SCORE;
-            long long so = evaluateLine(line, op);
-            if (so >= SCORE_WIN) return -INF_SCORE;
-            totalScore += sp;
-            totalScore -= so * DEFENSE_SCALE;
+    for (int d = 0; d < NUM_DIRS; d++) {
+        int pos = cellPos[idx][d];
+        int len = lineLen[cellLine[idx][d]];
+        int step = DIR_STEP[d];
+        for (int q = 0; q < 2; q++) {
+            if (board[idx] == 0) refreshStatus(q, idx, d);
+            for (int side = -1; side <= 1; side += 2) {
+                int c = idx;
+                for (int j = 1; j <= 4 && pos + j * side >= 0 && pos + j * side < len; j++) {
+                    c += side * step;
+                    if (board[c] == q + 1) continue;
+                    if (board[c] == 0) refreshStatus(q, c, d);
+                    break;
+                }
+            }
         }
     }
+}
+
+inline bool hasFourThreat(int p) {
+    const int* cnt = statusCount[p - 1];
+    return cnt[TYPE_CLOSED_4] + cnt[TYPE_OPEN_4] + cnt[TYPE_WIN] > 0;
+}
+
+int findThreat(int p, int minStatus) {
+    for (int i = 0; i < threatCount[p - 1]; i++) {
+        int c = threatList[p - 1][i];
+        if (cellStatus[p - 1][c] >= minStatus) return c;
+    }
+    return -1;
+}
+
+void makeMove(int idx, int p) {
+    if (++searchPly > selDepth) selDepth = searchPly;
+    board[idx] = p;
+    setStone(idx, p);
+    toggleHash(idx, p);
+    updateLines(idx);
+    updateWindows(idx, p, 1);
+    updateThreats(idx);
+
+    if (candPos[idx] >= 0) candRemove(idx);
+    for (int i = 0; i < numNeighbors[idx]; i++) {
+        int n = neighbors[idx][i];
+        if (neighborCount[n]++ == 0 && board[n] == 0) candAdd(n);
+    }
+}
+
+void unmakeMove(int idx, int p) {
+    searchPly--;
+    board[idx] = 0;
+    clearStone(idx, p);
+    toggleHash(idx, p);
+    updateLines(idx);
+    updateWindows(idx, p, -1);
+    updateThreats(idx);
+
+    for (int i = 0; i < numNeighbors[idx]; i++) {
+        int n = neighbors[idx][i];
+        if (--neighborCount[n] == 0 && candPos[n] >= 0) candRemove(n);
+    }
+    if (neighborCount[idx] > 0) candAdd(idx);
+}
+
+void resetSearchState() {
+    memset(board, 0, sizeof(board));
+    clearBitBoard();
+    resetEvalLines();
+    resetCandidates();
+    resetWindows();
+    resetThreats();
+}
+
+void initSearch() {
+    initBitBoard();
+    initCandidates();
+    initWindows();
+    resetSearchState();
+    if (bookPath) openBook(bookPath);
+}
+
+void loadPosition(const int* cells) {
+    resetSearchState();
+    resetHash();
+    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+        if (cells[i] != 0) makeMove(i, cells[i]);
+    }
+}
+
+long long evaluateBoard(int p) {
+    int op = (p == 1) ? 2 : 1;
+    if (winLines[p - 1] > 0) return INF_SCORE;
+    if (winLines[op - 1] > 0) return -INF_SCORE;
+
+    long long totalScore = lineScoreSum[p - 1];
+    totalScore -= lineScoreSum[op - 1] * DEFENSE_SCALE;
 
     if (NOISE_MAGNITUDE > 0 && abs(totalScore) < SCORE_DEAD_3) {
         totalScore += (long long)(rng() % (NOISE_MAGNITUDE * 2 + 1)) - NOISE_MAGNITUDE;
@@ -222,233 +437,379 @@ long long evaluateBoard(int p) {
 }
 
 vector<int> generateMoves() {
-    vector<int> moves;
-    int minX = BOARD_SIZE, maxX = 0, minY = BOARD_SIZE, maxY = 0;
-    bool empty = true;
-    for (int i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
-        if (board[i] != 0) {
-            empty = false;
-            int x = getX(i), y = getY(i);
-            minX = min(minX, x); maxX = max(maxX, x);
-            minY = min(minY, y); maxY = max(maxY, y);
-        }
-    }
-    if (empty) {
-        moves.push_back(getIdx(BOARD_SIZE / 2, BOARD_SIZE / 2));
-        return moves;
-    }
-    minX = max(0, minX - MOVE_GEN_RADIUS);
-    maxX = min(BOARD_SIZE - 1, maxX + MOVE_GEN_RADIUS);
-    minY = max(0, minY - MOVE_GEN_RADIUS);
-    maxY = min(BOARD_SIZE - 1, maxY + MOVE_GEN_RADIUS);
-
-    for (int y = minY; y <= maxY; y++) {
-        for (int x = minX; x <= maxX; x++) {
-            int idx = getIdx(x, y);
-            if (board[idx] == 0) {
-                bool hasNeighbor = false;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        if (dx == 0 && dy == 0) continue;
-                        int nx = x + dx, ny = y + dy;
-                        if (isValid(nx, ny) && board[getIdx(nx, ny)] != 0) {
-                            hasNeighbor = true;
-                            break;
-                        }
-                    }
-                    if (hasNeighbor) break;
-                }
-                if (hasNeighbor) moves.push_back(idx);
-            }
-        }
+    if (candCount == 0) {
+        int center = getIdx(BOARD_SIZE / 2, BOARD_SIZE / 2);
+        if (board[center] == 0) return vector<int>(1, center);
     }
-    return moves;
+    return vector<int>(candList, candList + candCount);
 }
 
 bool opponentHasDangerousThreat(int op) {
-    vector<int> moves = generateMoves();
-    for (int m : moves) {
-        board[m] = op;
-        int status = getMoveStatus(m, op);
-        board[m] = 0;
+    return hasFourThreat(op);
+}
 
-        if (status == TYPE_WIN) return true;
-        if (status == TYPE_OPEN_4) return true;
-        if (status == TYPE_CLOSED_4) return true;
+bool threatTimeUp() {
+    if ((sharedSearch && sharedSearch->stop)
+        || chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > threatLimitMs) {
+        timeOut = true;
     }
-    return false;
+    return timeOut;
 }
 
-bool solveVCF(int depth, int p, int& winMove) {
-    if (chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > VCT_TIME_LIMIT_MS) {
-        timeOut = true;
-        return false;
+// Cells of p's threat list with at least minStatus, strongest first.
+int collectThreats(int p, int minStatus, int* out) {
+    int n = 0;
+    for (int i = 0; i < threatCount[p - 1]; i++) {
+        int c = threatList[p - 1][i];
+        if (cellStatus[p - 1][c] >= minStatus) out[n++] = c;
     }
-    if (depth == 0) return false;
+    sort(out, out + n, [p](int a, int b) { return cellStatus[p - 1][a] > cellStatus[p - 1][b]; });
+    return n;
+}
 
+// Answers to p's open-four squares: empty cells on the threatened lines, at
+// most four steps away, after which p has no open four left to make.
+int threeDefenses(int p, int* out) {
     int op = (p == 1) ? 2 : 1;
-    vector<int> moves = generateMoves();
-    vector<int> candidates;
-
-    for (int m : moves) {
-        board[m] = p;
-        int status = getMoveStatus(m, p);
-        board[m] = 0;
-        if (status == TYPE_WIN) {
-            winMove = m;
-            return true;
-        }
-        if (status >= TYPE_CLOSED_4) {
-            candidates.push_back(m);
+    bool seen[BOARD_SIZE * BOARD_SIZE] = {};
+    int squares[BOARD_SIZE * BOARD_SIZE];
+    int numSquares = collectThreats(p, TYPE_OPEN_4, squares);
+    int n = 0;
+
+    for (int i = 0; i < numSquares; i++) {
+        int s = squares[i];
+        for (int d = 0; d < NUM_DIRS; d++) {
+            if (dirStatus[p - 1][s][d] < TYPE_OPEN_4) continue;
+            int pos = cellPos[s][d];
+            int len = lineLen[cellLine[s][d]];
+            int step = DIR_STEP[d];
+            for (int k = max(-4, -pos); k <= min(4, len - 1 - pos); k++) {
+                int c = s + k * step;
+                if (board[c] != 0 || seen[c]) continue;
+                seen[c] = true;
+
+                makeMove(c, op);
+                bool stops = statusCount[p - 1][TYPE_OPEN_4] + statusCount[p - 1][TYPE_WIN] == 0;
+                unmakeMove(c, op);
+                if (stops) out[n++] = c;
+            }
         }
     }
+    return n;
+}
 
-    if (candidates.empty()) return false;
+inline uint64_t threatKey(uint64_t hash, int attacker, bool vcfOnly) {
+    return hash ^ (attacker == 2 ? 0x9E3779B97F4A7C15ULL : 0) ^ (vcfOnly ? 0xC2B2AE3D27D4EB4FULL : 0);
+}
 
-    for (int m : candidates) {
-        board[m] = p;
+// Finished VCF/VCT results, shared by all threads and kept across moves. A
+// win holds for any deeper search and a failure for any shallower one. The
+// data word packs win | move+1 << 1 | depth << 11; the check word is the key
+// XOR-ed with it, as in the main TT.
+// With --sym-hash the key and move are those of the canonical orientation.
+struct ThreatSlot {
+    atomic<uint64_t> check;
+    atomic<uint64_t> data;
+};
+
+ThreatSlot threatCache[1 << THREAT_CACHE_BITS];
+
+bool threatCacheProbe(uint64_t key, int depth, bool& win, int& move) {
+    ThreatSlot& slot = threatCache[key & ((1u << THREAT_CACHE_BITS) - 1)];
+    uint64_t data = slot.data.load(memory_order_relaxed);
+    if ((slot.check.load(memory_order_relaxed) ^ data) != key) return false;
+
+    int storedDepth = (data >> 11) & 255;
+    win = data & 1;
+    move = (int)((data >> 1) & 1023) - 1;
+    return win ? depth >= storedDepth : depth <= storedDepth;
+}
 
-        if (opponentHasDangerousThreat(op)) {
-            board[m] = 0;
-            continue;
-        }
+void threatCacheStore(uint64_t key, int depth, bool win, int move) {
+    ThreatSlot& slot = threatCache[key & ((1u << THREAT_CACHE_BITS) - 1)];
+    uint64_t data = (uint64_t)win | (uint64_t)(move + 1) << 1 | (uint64_t)depth << 11;
+    slot.data.store(data, memory_order_relaxed);
+    slot.check.store(key ^ data, memory_order_relaxed);
+}
 
-        vector<int> forcedReplies;
-        vector<int> nextMoves = generateMoves();
-        for (int nm : nextMoves) {
-            board[nm] = p;
-            if (getMoveStatus(nm, p) == TYPE_WIN) {
-                forcedReplies.push_back(nm);
-            }
-            board[nm] = 0;
-        }
+void threatCacheClear() {
+    for (ThreatSlot& slot : threatCache) {
+        slot.check.store(0, memory_order_relaxed);
+        slot.data.store(0, memory_order_relaxed);
+    }
+}
 
-        bool defended = false;
-        if (forcedReplies.size() > 1) {
-            winMove = m;
-            board[m] = 0;
-            return true;
-        } else if (forcedReplies.size() == 1) {
-            int reply = forcedReplies[0];
-            board[reply] = op;
-            int tempMove;
-            if (!solveVCF(depth - 1, p, tempMove)) {
-                defended = true;
+bool solveVCF(int depth, int p, int& winMove) {
+    if (threatTimeUp() || depth == 0) return false;
+    if (statusCount[p - 1][TYPE_WIN] > 0) {
+        winMove = findThreat(p, TYPE_WIN);
+        return true;
+    }
+    int sym;
+    uint64_t key = threatKey(positionKey(sym), p, true);
+    bool cachedWin;
+    int cachedMove;
+    if (threatCacheProbe(key, depth, cachedWin, cachedMove)) {
+        if (cachedWin) winMove = fromCanonical(sym, cachedMove);
+        return cachedWin;
+    }
+
+    int op = (p == 1) ? 2 : 1;
+    int fours[BOARD_SIZE * BOARD_SIZE];
+    int n = collectThreats(p, TYPE_CLOSED_4, fours);
+
+    for (int i = 0; i < n; i++) {
+        int m = fours[i];
+        makeMove(m, p);
+
+        bool won = false;
+        if (!opponentHasDangerousThreat(op)) {
+            int wins = statusCount[p - 1][TYPE_WIN];
+            if (wins > 1) won = true;
+            else if (wins == 1) {
+                int reply = findThreat(p, TYPE_WIN);
+                makeMove(reply, op);
+                int tempMove;
+                won = solveVCF(depth - 1, p, tempMove);
+                unmakeMove(reply, op);
             }
-            board[reply] = 0;
-        } else {
-            defended = true;
         }
 
-        board[m] = 0;
-        if (!defended) {
+        unmakeMove(m, p);
+        if (won) {
             winMove = m;
+            threatCacheStore(key, depth, true, toCanonical(sym, m));
             return true;
         }
+        if (timeOut) return false;
     }
+    threatCacheStore(key, depth, false, -1);
     return false;
 }
 
+// Threat-space search over open threes: the defender only tries the cells
+// that actually stop the three, and a three nobody can stop wins outright.
 bool solveVCT(int depth, int p, int& winMove) {
-    if (chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > VCT_TIME_LIMIT_MS) {
-        timeOut = true;
-        return false;
-    }
-
+    if (threatTimeUp()) return false;
     if (solveVCF(depth, p, winMove)) return true;
-    if (depth == 0) return false;
+    if (depth == 0 || timeOut) return false;
+    int sym;
+    uint64_t key = threatKey(positionKey(sym), p, false);
+    bool cachedWin;
+    int cachedMove;
+    if (threatCacheProbe(key, depth, cachedWin, cachedMove)) {
+        if (cachedWin) winMove = fromCanonical(sym, cachedMove);
+        return cachedWin;
+    }
 
     int op = (p == 1) ? 2 : 1;
-    vector<int> moves = generateMoves();
-    vector<int> candidates;
+    int threes[BOARD_SIZE * BOARD_SIZE];
+    int n = collectThreats(p, TYPE_OPEN_3, threes);
+
+    for (int i = 0; i < n; i++) {
+        int m = threes[i];
+        if (cellStatus[p - 1][m] != TYPE_OPEN_3) continue;
+        makeMove(m, p);
+
+        bool won = false;
+        if (!opponentHasDangerousThreat(op) && statusCount[p - 1][TYPE_OPEN_4] > 0) {
+            int defenses[BOARD_SIZE * BOARD_SIZE];
+            int numDefenses = threeDefenses(p, defenses);
+            won = true;
+            for (int j = 0; j < numDefenses && won; j++) {
+                makeMove(defenses[j], op);
+                int tempMove;
+                won = solveVCT(depth - 1, p, tempMove);
+                unmakeMove(defenses[j], op);
+            }
+        }
 
-    for (int m : moves) {
-        board[m] = p;
-        int status = getMoveStatus(m, p);
-        board[m] = 0;
-        if (status == TYPE_OPEN_3 || status == TYPE_DEAD_3) {
-            candidates.push_back(m);
+        unmakeMove(m, p);
+        if (won) {
+            winMove = m;
+            threatCacheStore(key, depth, true, toCanonical(sym, m));
+            return true;
         }
+        if (timeOut) return false;
     }
+    threatCacheStore(key, depth, false, -1);
+    return false;
+}
 
-    for (int m : candidates) {
-        board[m] = p;
+// Depth-first proof-number search over the same threat tree as solveVCT:
+// the attacker only plays fours (and open threes unless vcfOnly), the
+// defender only the answers threeDefenses allows. Proof and disproof numbers
+// live in a per-thread table, so transpositions and re-searches are free.
+struct DfpnEntry {
+    uint64_t key;
+    uint32_t pn, dn;
+};
+
+thread_local vector<DfpnEntry> dfpnTable;
+thread_local long long dfpnNodes;
+thread_local int dfpnRootMove;
+
+void dfpnClear() {
+    if (dfpnTable.empty()) dfpnTable.resize(1u << DFPN_TABLE_BITS);
+    else fill(dfpnTable.begin(), dfpnTable.end(), DfpnEntry{0, 0, 0});
+}
 
-        if (opponentHasDangerousThreat(op)) {
-            board[m] = 0;
-            continue;
-        }
+inline void dfpnLookup(uint64_t key, uint32_t& pn, uint32_t& dn) {
+    const DfpnEntry& e = dfpnTable[key & ((1u << DFPN_TABLE_BITS) - 1)];
+    if (e.key == key) { pn = e.pn; dn = e.dn; }
+    else { pn = 1; dn = 1; }
+}
 
-        bool moveFailed = false;
-        vector<int> defMoves = generateMoves();
+inline void dfpnStore(uint64_t key, uint32_t pn, uint32_t dn) {
+    dfpnTable[key & ((1u << DFPN_TABLE_BITS) - 1)] = {key, pn, dn};
+}
 
-        for (int d : defMoves) {
-            board[d] = op;
+inline uint32_t dfpnAdd(uint32_t a, uint32_t b) {
+    return min(DFPN_INF, a + b);
+}
 
-            int opStatus = getMoveStatus(d, op);
-            if (opStatus == TYPE_WIN) {
-                board[d] = 0;
-                moveFailed = true;
-                break;
-            }
+// Children of the current node, or -1 when the node is already proven (the
+// attacker wins) and -2 when it is disproven.
+int dfpnChildren(int attacker, bool attackerToMove, bool vcfOnly, int* out) {
+    int p = attacker;
+    int op = (p == 1) ? 2 : 1;
+    if (attackerToMove) {
+        if (statusCount[p - 1][TYPE_WIN] > 0) return -1;
+        int n = collectThreats(p, vcfOnly ? TYPE_CLOSED_4 : TYPE_OPEN_3, out);
+        return n > 0 ? n : -2;
+    }
 
-            int tempMove;
-            bool pWins = solveVCT(depth - 1, p, tempMove);
-            board[d] = 0;
+    if (opponentHasDangerousThreat(op)) return -2;
+    int wins = statusCount[p - 1][TYPE_WIN];
+    if (wins > 1) return -1;
+    if (wins == 1) {
+        out[0] = findThreat(p, TYPE_WIN);
+        return 1;
+    }
+    if (vcfOnly || statusCount[p - 1][TYPE_OPEN_4] == 0) return -2;
+    int n = threeDefenses(p, out);
+    return n > 0 ? n : -1;
+}
+
+void dfpnSearch(int attacker, bool vcfOnly, int ply, uint32_t thPn, uint32_t thDn, uint32_t& pn, uint32_t& dn) {
+    int mover = (ply % 2 == 0) ? attacker : ((attacker == 1) ? 2 : 1);
+    bool orNode = mover == attacker;
+    int sym;
+    uint64_t key = threatKey(positionKey(sym), attacker, vcfOnly);
+    dfpnNodes++;
+
+    int moves[BOARD_SIZE * BOARD_SIZE];
+    int n = (ply >= DFPN_MAX_PLY) ? -2 : dfpnChildren(attacker, orNode, vcfOnly, moves);
+    if (n < 0) {
+        pn = (n == -1) ? 0 : DFPN_INF;
+        dn = (n == -1) ? DFPN_INF : 0;
+        dfpnStore(key, pn, dn);
+        return;
+    }
 
-            if (!pWins) {
-                moveFailed = true;
-                break;
+    uint64_t childKeys[BOARD_SIZE * BOARD_SIZE];
+    for (int i = 0; i < n; i++) {
+        childKeys[i] = threatKey(childKey(moves[i], mover), attacker, vcfOnly);
+    }
+
+    while (true) {
+        // From the mover's point of view: "phi" is the number it minimises.
+        uint32_t phiMin = DFPN_INF, phiSecond = DFPN_INF, deltaSum = 0, bestDelta = 0;
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            uint32_t cpn, cdn;
+            dfpnLookup(childKeys[i], cpn, cdn);
+            uint32_t phi = orNode ? cpn : cdn;
+            uint32_t delta = orNode ? cdn : cpn;
+            deltaSum = dfpnAdd(deltaSum, delta);
+            if (phi < phiMin) {
+                phiSecond = phiMin;
+                phiMin = phi;
+                bestDelta = delta;
+                best = i;
+            } else if (phi < phiSecond) {
+                phiSecond = phi;
             }
         }
+        pn = orNode ? phiMin : deltaSum;
+        dn = orNode ? deltaSum : phiMin;
+        if (ply == 0 && pn == 0) dfpnRootMove = moves[best];
+        if (pn >= thPn || dn >= thDn || ((dfpnNodes & 255) == 0 && threatTimeUp()) || timeOut) break;
+
+        uint32_t thPhi = orNode ? thPn : thDn;
+        uint32_t thDelta = orNode ? thDn : thPn;
+        uint32_t childPhi = min(thPhi, dfpnAdd(phiSecond, 1));
+        uint32_t childDelta = min(DFPN_INF, thDelta - deltaSum + bestDelta);
+
+        uint32_t cpn, cdn;
+        makeMove(moves[best], mover);
+        // The child's "phi" is this node's "delta" and vice versa.
+        if (orNode) dfpnSearch(attacker, vcfOnly, ply + 1, childPhi, childDelta, cpn, cdn);
+        else dfpnSearch(attacker, vcfOnly, ply + 1, childDelta, childPhi, cpn, cdn);
+        unmakeMove(moves[best], mover);
+    }
+    dfpnStore(key, pn, dn);
+}
 
-        board[m] = 0;
-        if (!moveFailed) {
-            winMove = m;
-            return true;
-        }
+// Proves or disproves a forced win for p within threatLimitMs. A false
+// result with timeOut set means the proof was not finished.
+bool proveWin(int p, bool vcfOnly, int& winMove) {
+    if (statusCount[p - 1][TYPE_WIN] > 0) {
+        winMove = findThreat(p, TYPE_WIN);
+        return true;
     }
-    return false;
+    dfpnClear();
+    dfpnNodes = 0;
+    dfpnRootMove = -1;
+    uint32_t pn, dn;
+    dfpnSearch(p, vcfOnly, 0, DFPN_INF - 1, DFPN_INF - 1, pn, dn);
+    if (pn != 0) return false;
+    winMove = dfpnRootMove;
+    return true;
 }
 
 long long alphaBeta(int depth, long long alpha, long long beta, int p) {
     nodesCount++;
     if ((nodesCount & 1023) == 0) {
-        if (chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > TIME_LIMIT_MS) {
+        if ((sharedSearch && sharedSearch->stop) || (nodeLimit && nodesCount >= nodeLimit)
+            || (!pondering && chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() > hardLimitMs)) {
             timeOut = true;
         }
     }
     if (timeOut) return 0;
 
-    int idx = currentHash & (TT_TABLE_SIZE - 1);
-    if (TTable[idx].key == currentHash && TTable[idx].depth >= depth) {
-        if (TTable[idx].flag == FLAG_EXACT) return TTable[idx].score;
-        if (TTable[idx].flag == FLAG_LOWERBOUND && TTable[idx].score >= beta) return beta;
-        if (TTable[idx].flag == FLAG_UPPERBOUND && TTable[idx].score <= alpha) return alpha;
+    TTEntry tt;
+    bool ttHit = ttProbePosition(tt);
+    if (ttHit && tt.depth >= depth) {
+        if (tt.flag == FLAG_EXACT) return tt.score;
+        if (tt.flag == FLAG_LOWERBOUND && tt.score >= beta) return beta;
+        if (tt.flag == FLAG_UPPERBOUND && tt.score <= alpha) return alpha;
     }
     if (depth == 0) return evaluateBoard(p);
 
+    int op = (p == 1) ? 2 : 1;
+    if (statusCount[p - 1][TYPE_WIN] > 0) return INF_SCORE;
+    // Against a four, only the blocking cells can avoid losing.
+    bool mustBlock = statusCount[op - 1][TYPE_WIN] > 0;
+
     vector<int> moves = generateMoves();
     if (moves.empty()) return 0;
     int bestMove = -1;
-    if (TTable[idx].key == currentHash) bestMove = TTable[idx].bestMove;
+    if (ttHit) bestMove = tt.bestMove;
 
     vector<pair<long long, int>> orderedMoves;
     orderedMoves.reserve(moves.size());
 
     for (int m : moves) {
+        if (mustBlock && cellStatus[op - 1][m] != TYPE_WIN) continue;
         long long score = 0;
         if (m == bestMove) score = 1e18;
         else {
-            board[m] = p;
-            int stat = getMoveStatus(m, p);
-            board[m] = 0;
+            int stat = cellStatus[p - 1][m];
             if (stat >= TYPE_CLOSED_4) score = 1e17;
             else if (stat >= TYPE_OPEN_3) score = 1e16;
             else {
-                board[m] = (p == 1 ? 2 : 1);
-                int opStat = getMoveStatus(m, (p == 1 ? 2 : 1));
-                board[m] = 0;
+                int opStat = cellStatus[op - 1][m];
                 if (opStat >= TYPE_CLOSED_4) score = 1e16;
                 else score = history[m];
             }
@@ -457,6 +818,7 @@ long long alphaBeta(int depth, long long alpha, long long beta, int p) {
         else if (m == killerMoves[depth][1]) score += 5000;
         orderedMoves.push_back({score, m});
     }
+    if (orderedMoves.empty()) return -INF_SCORE;
     sort(orderedMoves.begin(), orderedMoves.end(), [](const pair<long long, int>& a, const pair<long long, int>& b) {
         return a.first > b.first;
     });
@@ -468,20 +830,24 @@ long long alphaBeta(int depth, long long alpha, long long beta, int p) {
 
     for (auto& pair : orderedMoves) {
         int m = pair.second;
-        board[m] = p;
-        if (getMoveStatus(m, p) == TYPE_WIN) {
-            board[m] = 0;
-            return INF_SCORE;
+        // Late quiet moves (no threat made or blocked, not hash or killer)
+        // get a shallower null-window search first and are re-searched at
+        // full depth only if they beat alpha.
+        int reduction = 0;
+        if (depth >= LMR_MIN_DEPTH && movesSearched >= LMR_MIN_MOVES && !mustBlock && pair.first < 1e16
+            && m != killerMoves[depth][0] && m != killerMoves[depth][1]
+            && cellStatus[p - 1][m] < TYPE_OPEN_3 && cellStatus[op - 1][m] < TYPE_OPEN_3) {
+            reduction = (movesSearched >= LMR_LATE_MOVES && depth > LMR_MIN_DEPTH) ? 2 : 1;
         }
-        toggleHash(m, p);
+        makeMove(m, p);
         long long val;
-        if (movesSearched == 0) val = -alphaBeta(depth - 1, -beta, -alpha, (p == 1) ? 2 : 1);
+        if (movesSearched == 0) val = -alphaBeta(depth - 1, -beta, -alpha, op);
         else {
-            val = -alphaBeta(depth - 1, -alpha - 1, -alpha, (p == 1) ? 2 : 1);
-            if (val > alpha && val < beta) val = -alphaBeta(depth - 1, -beta, -alpha, (p == 1) ? 2 : 1);
+            val = reduction ? -alphaBeta(depth - 1 - reduction, -alpha - 1, -alpha, op) : alpha + 1;
+            if (val > alpha) val = -alphaBeta(depth - 1, -alpha - 1, -alpha, op);
+            if (val > alpha && val < beta) val = -alphaBeta(depth - 1, -beta, -alpha, op);
         }
-        toggleHash(m, p);
-        board[m] = 0;
+        unmakeMove(m, p);
         if (timeOut) return 0;
         movesSearched++;
         if (val > bestVal) {
@@ -503,123 +869,453 @@ long long alphaBeta(int depth, long long alpha, long long beta, int p) {
             break;
         }
     }
-    if (!timeOut) TTable[idx] = {currentHash, depth, bestVal, flag, moveIdx};
+    if (!timeOut) ttStorePosition(depth, bestVal, flag, moveIdx);
     return bestVal;
 }
 
+int rootHashMove(int bestMove) {
+    TTEntry tt;
+    if (ttProbePosition(tt) && tt.bestMove >= 0 && tt.bestMove < BOARD_SIZE * BOARD_SIZE && board[tt.bestMove] == 0) return tt.bestMove;
+    return bestMove;
+}
+
+int searchRoot(int d, const vector<int>& moves, int bestMove, long long alpha, long long beta, long long& bestVal) {
+    bestVal = -INF_SCORE * 2;
+    int curMove = -1;
+
+    vector<pair<long long, int>> rootMoves;
+    for (int m : moves) {
+        long long s = history[m];
+        if (m == bestMove) s += 1e18;
+        rootMoves.push_back({s, m});
+    }
+    sort(rootMoves.begin(), rootMoves.end(), [](auto& a, auto& b) { return a.first > b.first; });
+
+    int movesSearched = 0;
+    for (auto& pair : rootMoves) {
+        int m = pair.second;
+        makeMove(m, myID);
+        long long val;
+        if (movesSearched == 0) val = -alphaBeta(d - 1, -beta, -alpha, opID);
+        else {
+            val = -alphaBeta(d - 1, -alpha - 1, -alpha, opID);
+            if (!timeOut && val > alpha && val < beta) val = -alphaBeta(d - 1, -beta, -alpha, opID);
+        }
+        unmakeMove(m, myID);
+        if (timeOut) break;
+        movesSearched++;
+        if (val > bestVal) {
+            bestVal = val;
+            curMove = m;
+        }
+        alpha = max(alpha, bestVal);
+        if (alpha >= beta) break;
+    }
+    return curMove;
+}
+
+// Searches depth d in a window around the previous iteration's score and
+// widens the side that fails until the score lands inside. On a timeout the
+// move is only kept if it was not a fail-low.
+int aspirationSearch(int d, const vector<int>& moves, int bestMove, bool havePrev, long long prevScore, long long& bestVal) {
+    long long window = ASPIRATION_WINDOW;
+    long long alpha = -INF_SCORE * 2, beta = INF_SCORE * 2;
+    if (havePrev && abs(prevScore) < SCORE_WIN) {
+        alpha = prevScore - window;
+        beta = prevScore + window;
+    }
+
+    while (true) {
+        int curMove = searchRoot(d, moves, bestMove, alpha, beta, bestVal);
+        if (timeOut) return bestVal > alpha ? curMove : -1;
+        if (bestVal <= alpha && alpha > -INF_SCORE * 2) {
+            window *= 4;
+            alpha = window >= SCORE_WIN ? -INF_SCORE * 2 : max(-INF_SCORE * 2, bestVal - window);
+        } else if (bestVal >= beta && beta < INF_SCORE * 2) {
+            window *= 4;
+            beta = window >= SCORE_WIN ? INF_SCORE * 2 : min(INF_SCORE * 2, bestVal + window);
+            bestMove = curMove;
+        } else {
+            return curMove;
+        }
+    }
+}
+
+// History and killers carry over from the previous move; history is only
+// aged, so the last search still orders the next one.
+void ageHistory() {
+    for (long long& h : history) h >>= HISTORY_AGE_SHIFT;
+}
+
+// Lazy SMP helper: searches the same root on its own copy of the position,
+// offset by one ply from its neighbours, and only feeds the shared TT.
+void helperSearch(int id, SharedSearch* shared, chrono::steady_clock::time_point start,
+                  int me, int op, vector<int> cells, vector<int> moves, vector<long long> hist) {
+    loadPosition(cells.data());
+    copy(hist.begin(), hist.end(), history);
+    sharedSearch = shared;
+    pondering = shared->pondering;
+    hardLimitMs = shared->hardLimitMs;
+    startTime = start;
+    myID = me;
+    opID = op;
+    timeOut = false;
+    nodesCount = 0;
+
+    int bestMove = moves[0];
+    long long bestVal = 0;
+    for (int d = 1 + id % 2; d <= depthLimit; d++) {
+        bestMove = rootHashMove(bestMove);
+        int curMove = aspirationSearch(d, moves, bestMove, d > 1 + id % 2, bestVal, bestVal);
+        if (timeOut || curMove == -1) break;
+        bestMove = curMove;
+        if (bestVal >= SCORE_WIN) break;
+    }
+    shared->nodes += nodesCount;
+}
+
+// bestMove followed by the TT moves of the positions it leads to, as long
+// as they stay legal and nobody has won yet.
+vector<int> extractPV(int bestMove, int maxLen) {
+    vector<int> pv;
+    int p = myID;
+    int m = bestMove;
+    int savedSelDepth = selDepth;
+    while (m >= 0 && m < BOARD_SIZE * BOARD_SIZE && board[m] == 0 && (int)pv.size() < maxLen) {
+        bool wins = cellStatus[p - 1][m] == TYPE_WIN;
+        pv.push_back(m);
+        makeMove(m, p);
+        p = (p == 1) ? 2 : 1;
+        TTEntry tt;
+        m = (!wins && ttProbePosition(tt)) ? tt.bestMove : -1;
+    }
+    for (int i = (int)pv.size() - 1; i >= 0; i--) {
+        p = (p == 1) ? 2 : 1;
+        unmakeMove(pv[i], p);
+    }
+    selDepth = savedSelDepth;
+    return pv;
+}
+
+string movesJson(const vector<int>& moves) {
+    string out = "[";
+    for (size_t i = 0; i < moves.size(); i++) out += (i ? ",\"" : "\"") + move_to_str(moves[i]) + "\"";
+    return out + "]";
+}
+
+long long searchElapsedMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+// Every search line is one JSON object: an "info" per finished depth, one
+// "threat" for the VCF/VCT pass and a final "bestmove" with the totals.
+void logIteration(int d, long long score, long long elapsed, int bestMove, bool timedOut) {
+    vector<int> pv = extractPV(bestMove, d);
+    *searchLog << "{\"type\":\"info\",\"depth\":" << d
+        << ",\"seldepth\":" << selDepth
+        << ",\"score\":" << score
+        << ",\"nodes\":" << nodesCount
+        << ",\"nps\":" << nodesCount * 1000 / max(elapsed, 1LL)
+        << ",\"time\":" << elapsed
+        << ",\"pv\":" << movesJson(pv)
+        << (timedOut ? ",\"timeout\":true" : "")
+        << "}" << endl;
+}
+
+int finishSolve(int bestMove, const char* reason) {
+    long long elapsed = searchElapsedMs();
+    searchInfo.bestMove = bestMove;
+    searchInfo.selDepth = selDepth;
+    searchInfo.nodes = max(searchInfo.nodes, nodesCount);
+    searchInfo.pv = extractPV(bestMove, max(searchInfo.depth, 1));
+
+    *searchLog << "{\"type\":\"bestmove\",\"move\":\"" << move_to_str(bestMove) << "\""
+        << ",\"reason\":\"" << reason << "\""
+        << ",\"depth\":" << searchInfo.depth
+        << ",\"seldepth\":" << searchInfo.selDepth
+        << ",\"score\":" << searchInfo.score
+        << ",\"nodes\":" << searchInfo.nodes
+        << ",\"nps\":" << searchInfo.nodes * 1000 / max(elapsed, 1LL)
+        << ",\"time\":" << elapsed
+        << ",\"tt_fill\":" << ttHashfull()
+        << ",\"tt_hit_rate\":" << fixed << setprecision(4) << (ttProbes ? (double)ttHits / ttProbes : 0.0) << defaultfloat
+        << ",\"threat_ms\":" << searchInfo.threatMs
+        << ",\"pv\":" << movesJson(searchInfo.pv)
+        << "}" << endl;
+    return bestMove;
+}
+
+struct TimePlan {
+    long long optimumMs;
+    long long maximumMs;
+};
+
+// The budget is the per-move budget, or an even share of the clock over
+// the moves a game usually has left. An ordinary move aims for half of it;
+// the budget itself is a hard cap, so move latency stays bounded.
+TimePlan planTime() {
+    long long budget = moveBudgetMs > 0 ? moveBudgetMs : timeLimitMs;
+    if (clockMs > 0) {
+        int stones = 0;
+        for (int y = 0; y < BOARD_SIZE; y++) stones += __builtin_popcount(rowOccupied[y]);
+        long long movesLeft = max(10, 60 - stones / 2);
+        budget = min(budget, clockMs / movesLeft);
+    }
+    budget = max(budget, (long long)MIN_MOVE_MS);
+    return {budget / 2, budget};
+}
+
 int solve() {
     startTime = chrono::steady_clock::now();
+    TimePlan plan = planTime();
+    hardLimitMs = plan.maximumMs;
+    threatLimitMs = (int)min((long long)VCT_TIME_LIMIT_MS, max(plan.maximumMs / 5, 5LL));
     timeOut = false;
+    ttNewSearch();
     nodesCount = 0;
-    memset(history, 0, sizeof(history));
-    memset(killerMoves, 0, sizeof(killerMoves));
+    ttProbes = ttHits = 0;
+    searchPly = selDepth = 0;
+    searchInfo.reset();
+    ageHistory();
 
     vector<int> moves = generateMoves();
-    for (int m : moves) {
-        board[m] = myID;
-        if (getMoveStatus(m, myID) == TYPE_WIN) { board[m] = 0; return m; }
-        board[m] = 0;
-    }
-    for (int m : moves) {
-        board[m] = opID;
-        if (getMoveStatus(m, opID) == TYPE_WIN) { board[m] = 0; return m; }
-        board[m] = 0;
+    if (statusCount[myID - 1][TYPE_WIN] > 0) return finishSolve(findThreat(myID, TYPE_WIN), "win");
+    if (statusCount[opID - 1][TYPE_WIN] > 0) return finishSolve(findThreat(opID, TYPE_WIN), "block");
+
+    int bookMove;
+    BookEntry book;
+    if (bookProbe(bookMove, book)) {
+        searchInfo.depth = book.depth;
+        searchInfo.score = book.score;
+        return finishSolve(bookMove, "book");
     }
 
-    int vctMove = -1;
-    if (solveVCT(VCT_DEPTH, myID, vctMove)) {
-        return vctMove;
+    // The bench turns the threat pass off to time the alpha-beta search alone.
+    if (USE_THREAT_PASS) {
+        int vctMove = -1;
+        bool vctWin = USE_DFPN ? proveWin(myID, false, vctMove) : solveVCT(VCT_DEPTH, myID, vctMove);
+        searchInfo.threatMs = searchElapsedMs();
+        searchInfo.threatWin = vctWin;
+        searchInfo.threatTimeout = timeOut;
+        *searchLog << "{\"type\":\"threat\",\"solver\":\"" << (USE_DFPN ? "dfpn" : "vct") << "\""
+            << ",\"result\":\"" << (vctWin ? "win" : timeOut ? "timeout" : "none") << "\""
+            << ",\"move\":\"" << move_to_str(vctWin ? vctMove : -1) << "\""
+            << ",\"seldepth\":" << selDepth
+            << ",\"time\":" << searchInfo.threatMs << "}" << endl;
+        if (vctWin) return finishSolve(vctMove, "vct");
+        // The threat line reported how deep the solver went; seldepth of
+        // the info lines is the alpha-beta search's own.
+        selDepth = 0;
     }
 
     if (timeOut) {
-        if (chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() < TIME_LIMIT_MS) {
+        if (searchElapsedMs() < hardLimitMs) {
             timeOut = false;
         } else {
-            return moves[0];
+            return finishSolve(moves[0], "timeout");
         }
     }
 
     if (NOISE_MAGNITUDE > 0) shuffle(moves.begin(), moves.end(), rng);
 
     int bestMove = moves[0];
-    if (moves.size() == 1) return bestMove;
-
-    for (int d = 1; d <= MAX_SEARCH_DEPTH; d++) {
-        long long bestVal = -INF_SCORE * 2;
-        int curMove = -1;
-        long long alpha = -INF_SCORE * 2;
-        long long beta = INF_SCORE * 2;
-        int idx = currentHash & (TT_TABLE_SIZE - 1);
-        if (TTable[idx].key == currentHash && TTable[idx].bestMove != -1) bestMove = TTable[idx].bestMove;
-
-        vector<pair<long long, int>> rootMoves;
-        for (int m : moves) {
-            long long s = history[m];
-            if (m == bestMove) s += 1e18;
-            rootMoves.push_back({s, m});
-        }
-        sort(rootMoves.begin(), rootMoves.end(), [](auto& a, auto& b) { return a.first > b.first; });
-
-        for (auto& pair : rootMoves) {
-            int m = pair.second;
-            board[m] = myID;
-            toggleHash(m, myID);
-            long long val = -alphaBeta(d - 1, -beta, -alpha, opID);
-            toggleHash(m, myID);
-            board[m] = 0;
-            if (timeOut) break;
-            if (val > bestVal) {
-                bestVal = val;
-                curMove = m;
-            }
-            alpha = max(alpha, bestVal);
+    if (moves.size() == 1) return finishSolve(bestMove, "only");
+
+    SharedSearch shared;
+    shared.pondering = pondering;
+    shared.hardLimitMs = hardLimitMs;
+    vector<thread> helpers;
+    if (SEARCH_THREADS > 1) {
+        vector<int> cells(board, board + BOARD_SIZE * BOARD_SIZE);
+        vector<long long> hist(history, history + BOARD_SIZE * BOARD_SIZE);
+        for (int i = 1; i < SEARCH_THREADS; i++) {
+            helpers.emplace_back(helperSearch, i, &shared, startTime, myID, opID, cells, moves, hist);
         }
+    }
+
+    long long lastElapsed = 0, lastIterMs = 0, prevScore = 0;
+    int stableIters = 0;
+    for (int d = 1; d <= depthLimit; d++) {
+        bestMove = rootHashMove(bestMove);
+        long long bestVal;
+        int curMove = aspirationSearch(d, moves, bestMove, d > 1, prevScore, bestVal);
 
         auto now = chrono::steady_clock::now();
         auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - startTime).count();
 
         if (!timeOut && curMove != -1) {
+            stableIters = (curMove == bestMove) ? stableIters + 1 : 0;
             bestMove = curMove;
-            cerr << "depth:" << d
-                << ",  eval:" << bestVal
-                << ",  nodes:" << nodesCount
-                << ",  time:" << elapsed << "ms"
-                << ",  best:" << move_to_str(bestMove)
-                << endl;
+            searchInfo.depth = d;
+            searchInfo.score = bestVal;
+            prevScore = bestVal;
+            searchInfo.depthMs.push_back(elapsed);
+            logIteration(d, bestVal, elapsed, bestMove, false);
 
             if (bestVal >= SCORE_WIN) break;
+
+            // Stop early once the best move has settled, allow more while it
+            // keeps changing, and never start a depth that cannot finish.
+            long long iterMs = elapsed - lastElapsed;
+            double growth = lastIterMs > 0 ? min(8.0, max(2.0, (double)iterMs / lastIterMs)) : 4.0;
+            double scale = stableIters >= 3 ? 0.6 : (stableIters == 0 && d > 1 ? 1.6 : 1.0);
+            long long target = min(plan.maximumMs, (long long)(plan.optimumMs * scale));
+            lastElapsed = elapsed;
+            lastIterMs = iterMs;
+            if (!pondering && (elapsed >= target || elapsed + iterMs * growth > plan.maximumMs)) break;
         } else {
-            cerr << "depth:" << d
-                << ",  eval:" << bestVal
-                << ",  nodes:" << nodesCount
-                << ",  time:" << elapsed << "ms"
-                << ",  best:" << move_to_str(bestMove)
-                << "  [TIMEOUT]"
-                << endl;
+            // A move that beat the previous best before the timeout was
+            // searched to the full depth, so the partial iteration counts.
+            if (curMove != -1) bestMove = curMove;
+            logIteration(d, bestVal, elapsed, bestMove, true);
             break;
         }
     }
-    cerr << "bestmove " << move_to_str(bestMove) << endl;
-    return bestMove;
+
+    shared.stop = true;
+    for (auto& t : helpers) t.join();
+    searchInfo.nodes = nodesCount + shared.nodes;
+    return finishSolve(bestMove, "search");
+}
+
+// After answering, the bot keeps searching the reply it expects (the TT
+// move of the new position) on a background thread with no time limit. If
+// that reply comes, the search is stopped once it has had the usual budget
+// and its move is played; any other reply just stops it.
+struct Ponder {
+    thread worker;
+    SharedSearch control;
+    chrono::steady_clock::time_point start;
+    int move = -1;
+    int result = -1;
+    atomic<bool> done{false};
+    ostringstream log;
+    vector<long long> hist;
+};
+
+unique_ptr<Ponder> ponderTask;
+
+void ponderSearch(Ponder* task, vector<int> cells, int me, int op, vector<long long> hist) {
+    loadPosition(cells.data());
+    myID = me;
+    opID = op;
+    copy(hist.begin(), hist.end(), history);
+    sharedSearch = &task->control;
+    pondering = true;
+    searchLog = &task->log;
+
+    task->result = solve();
+    task->hist.assign(history, history + BOARD_SIZE * BOARD_SIZE);
+    task->done = true;
+}
+
+void startPonder() {
+    TTEntry tt;
+    if (winLines[myID - 1] > 0 || !ttProbePosition(tt)) return;
+    int reply = tt.bestMove;
+    if (reply < 0 || reply >= BOARD_SIZE * BOARD_SIZE || board[reply] != 0 || cellStatus[opID - 1][reply] == TYPE_WIN) return;
+
+    ponderTask.reset(new Ponder());
+    ponderTask->move = reply;
+    ponderTask->start = chrono::steady_clock::now();
+    vector<int> cells(board, board + BOARD_SIZE * BOARD_SIZE);
+    cells[reply] = opID;
+    ponderTask->worker = thread(ponderSearch, ponderTask.get(), cells, myID, opID,
+                                vector<long long>(history, history + BOARD_SIZE * BOARD_SIZE));
+}
+
+// Stops the ponder search; returns its move if it pondered on `move`, else -1.
+int finishPonder(int move) {
+    if (!ponderTask) return -1;
+    Ponder& task = *ponderTask;
+    bool hit = move == task.move;
+    if (hit) {
+        auto until = task.start + chrono::milliseconds(planTime().optimumMs);
+        while (!task.done && chrono::steady_clock::now() < until) this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    task.control.stop = true;
+    task.worker.join();
+
+    int result = -1;
+    if (hit) {
+        result = task.result;
+        copy(task.hist.begin(), task.hist.end(), history);
+        *searchLog << "{\"type\":\"ponderhit\",\"move\":\"" << move_to_str(move) << "\"}" << endl << task.log.str();
+    }
+    ponderTask.reset();
+    return result;
+}
+
+// One turn of the stdin protocol: applies the opponent move (-1 when the
+// bot opens) and returns the bot's reply, already played on the board.
+int nextMove(int move) {
+    auto received = chrono::steady_clock::now();
+    int best = finishPonder(move);
+    if (move != -1) {
+        makeMove(move, opID);
+    } else {
+        myID = 1; opID = 2;
+    }
+    if (best == -1) best = solve();
+    makeMove(best, myID);
+    if (clockMs > 0) {
+        clockMs -= chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - received).count();
+        clockMs = max(clockMs, 1LL);
+    }
+    return best;
+}
+
+void parseArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0) SEARCH_THREADS = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--dfpn") == 0) USE_DFPN = atoi(argv[++i]) != 0;
+        else if (strcmp(argv[i], "--ponder") == 0) USE_PONDER = atoi(argv[++i]) != 0;
+        else if (strcmp(argv[i], "--time") == 0) timeLimitMs = max(MIN_MOVE_MS, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--clock") == 0) clockMs = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--book") == 0) bookPath = argv[++i];
+        else if (parseTTOption(argv[i], argv[i + 1])) i++;
+    }
+}
+
+// Standalone prover: reads a move list (players alternate, 1 first) and
+// reports whether the side to move has a forced VCF or VCT win.
+int provePosition(int ms) {
+    int move, p = 1;
+    while (cin >> move) {
+        makeMove(move, p);
+        p = (p == 1) ? 2 : 1;
+    }
+
+    threatLimitMs = ms;
+    startTime = chrono::steady_clock::now();
+    timeOut = false;
+    int winMove = -1;
+    bool win = proveWin(p, true, winMove);
+    if (!win && !timeOut) win = proveWin(p, false, winMove);
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+
+    if (win) cout << "win " << move_to_str(winMove);
+    else cout << (timeOut ? "unknown" : "nowin");
+    cout << "  nodes:" << dfpnNodes << "  time:" << elapsed << "ms" << endl;
+    return 0;
 }
 
 #ifndef LIB_MODE
-int main() {
+int main(int argc, char** argv) {
     setbuf(stderr, NULL);
+    parseArgs(argc, argv);
     initZobrist();
+    if (!initTT()) return 1;
+    initSearch();
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--prove") == 0) return provePosition(atoi(argv[i + 1]));
+    }
     int move;
     while (cin >> move) {
-        if (move != -1) {
-            board[move] = opID;
-            toggleHash(move, opID);
-        } else {
-            myID = 1; opID = 2;
-        }
-        int best = solve();
-        board[best] = myID;
-        toggleHash(best, myID);
-        cout << best << endl;
+        cout << nextMove(move) << endl;
+        if (USE_PONDER) startPonder();
     }
+    finishPonder(-1);
     return 0;
 }
 #endif
@@ -0,0 +1,205 @@
+#define LIB_MODE
+#include "bot_level_3.cpp"
+#include "../logic/Referee.cpp"
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <condition_variable>
+#include <cstdio>
+
+// Long-running host for many games in one process. stdin carries fixed-size
+// little-endian HostRequest frames and every request gets one HostReply on
+// stdout, tagged with its game id and the request's seq. Replies to one game
+// can overtake each other (OP_END answers at once, OP_PLAY after the search),
+// so callers match them by seq:
+//   OP_NEW   -> status 0; timeMs is the bot's clock for the game (0: none)
+//   OP_PLAY  -> applies the opponent move (-1 asks the bot to open, which is
+//               only legal on an empty board), validates it, searches and
+//               applies the bot move in one round-trip;
+//               status is -1 for an illegal move, 1 if that move won, else 0;
+//               the bot move is -1 when the board is full;
+//               timeMs is a budget for this move (0: the default)
+//   OP_END   -> status 0
+// Search logs go to stderr as text lines "<game> <line>".
+
+const uint8_t OP_NEW = 0;
+const uint8_t OP_PLAY = 1;
+const uint8_t OP_END = 2;
+
+#pragma pack(push, 1)
+struct HostRequest {
+    uint32_t game;
+    uint32_t seq;
+    uint8_t op;
+    int16_t move;
+    uint32_t timeMs;
+};
+
+struct HostReply {
+    uint32_t game;
+    uint32_t seq;
+    int8_t status;
+    int16_t move;
+    int8_t botWon;
+};
+#pragma pack(pop)
+
+// A game is queued on the worker pool at most once; moves that arrive while
+// it is queued or being searched wait in pending, so they run in order.
+struct Game {
+    uint32_t id;
+    Referee<BOARD_SIZE> referee;
+    int botID = 2;
+    int humanID = 1;
+    deque<HostRequest> pending;
+    bool scheduled = false;
+    long long clockMs = 0;
+    long long history[BOARD_SIZE * BOARD_SIZE] = {};
+    long long killerMoves[MAX_SEARCH_DEPTH][2] = {};
+};
+
+int HOST_WORKERS = 1;
+
+map<uint32_t, shared_ptr<Game>> games;
+mutex gamesLock;
+deque<shared_ptr<Game>> jobs;
+mutex jobsLock;
+condition_variable jobsReady;
+mutex outLock;
+
+void reply(const HostRequest& req, int status, int move, bool botWon) {
+    HostReply r = {req.game, req.seq, (int8_t)status, (int16_t)move, (int8_t)botWon};
+    lock_guard<mutex> g(outLock);
+    fwrite(&r, sizeof(r), 1, stdout);
+    fflush(stdout);
+}
+
+void flushLog(uint32_t game, const string& text) {
+    istringstream in(text);
+    string line;
+    lock_guard<mutex> g(outLock);
+    while (getline(in, line)) cerr << game << ' ' << line << '\n';
+    cerr.flush();
+}
+
+void playMove(Game& game, const HostRequest& req) {
+    int move = req.move;
+    if (move == -1) {
+        // Passing is only a request for the bot to open the game.
+        if (game.referee.stones != 0) {
+            reply(req, REF_ILLEGAL, -1, false);
+            return;
+        }
+        game.botID = 1;
+        game.humanID = 2;
+    } else {
+        int status = game.referee.play(move, game.humanID);
+        if (status != REF_PLAYED) {
+            reply(req, status, -1, false);
+            return;
+        }
+    }
+    // A full board is a draw; there is nothing left to search.
+    if (game.referee.stones == BOARD_SIZE * BOARD_SIZE) {
+        reply(req, REF_PLAYED, -1, false);
+        return;
+    }
+
+    // Workers serve many games, so move ordering state travels with the game.
+    loadPosition(game.referee.cells);
+    myID = game.botID;
+    opID = game.humanID;
+    memcpy(history, game.history, sizeof(history));
+    memcpy(killerMoves, game.killerMoves, sizeof(killerMoves));
+    clockMs = game.clockMs;
+    moveBudgetMs = req.timeMs;
+    int best = solve();
+    if (game.clockMs > 0) {
+        long long used = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+        game.clockMs = max(game.clockMs - used, 1LL);
+    }
+    memcpy(game.history, history, sizeof(history));
+    memcpy(game.killerMoves, killerMoves, sizeof(killerMoves));
+    reply(req, 0, best, game.referee.play(best, myID) == REF_WIN);
+}
+
+void worker() {
+    ostringstream log;
+    searchLog = &log;
+    while (true) {
+        shared_ptr<Game> game;
+        HostRequest job;
+        {
+            unique_lock<mutex> g(jobsLock);
+            jobsReady.wait(g, [] { return !jobs.empty(); });
+            game = jobs.front();
+            jobs.pop_front();
+            job = game->pending.front();
+            game->pending.pop_front();
+        }
+        playMove(*game, job);
+        flushLog(game->id, log.str());
+        log.str("");
+
+        lock_guard<mutex> g(jobsLock);
+        if (game->pending.empty()) {
+            game->scheduled = false;
+        } else {
+            jobs.push_back(game);
+            jobsReady.notify_one();
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0) HOST_WORKERS = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--model") == 0 && strcmp(argv[++i], "bot_final") == 0) {
+            NOISE_MAGNITUDE = 20000;
+            DEFENSE_SCALE = 1.2;
+        }
+    }
+    initZobrist();
+    if (!initTT()) return 1;
+    initSearch();
+
+    vector<thread> pool;
+    for (int i = 0; i < HOST_WORKERS; i++) pool.emplace_back(worker);
+
+    HostRequest req;
+    while (fread(&req, sizeof(req), 1, stdin) == 1) {
+        if (req.op == OP_NEW) {
+            auto game = make_shared<Game>();
+            game->id = req.game;
+            game->referee.reset();
+            game->clockMs = req.timeMs;
+            lock_guard<mutex> g(gamesLock);
+            games[req.game] = game;
+        } else if (req.op == OP_END) {
+            lock_guard<mutex> g(gamesLock);
+            games.erase(req.game);
+        } else if (req.op == OP_PLAY) {
+            shared_ptr<Game> game;
+            {
+                lock_guard<mutex> g(gamesLock);
+                auto it = games.find(req.game);
+                if (it != games.end()) game = it->second;
+            }
+            if (!game) { reply(req, -1, -1, false); continue; }
+            lock_guard<mutex> g(jobsLock);
+            game->pending.push_back(req);
+            if (!game->scheduled) {
+                game->scheduled = true;
+                jobs.push_back(game);
+                jobsReady.notify_one();
+            }
+            continue;
+        }
+        reply(req, 0, -1, false);
+    }
+    ttRelease();
+    _exit(0);
+}
@@ -1,11 +1,21 @@
-g++ -O3 modules/models/bot_level_1.cpp -o modules/models/bot_level_1
-g++ -O3 modules/models/bot_level_2.cpp -o modules/models/bot_level_2
-g++ -O3 modules/models/bot_level_3.cpp -o modules/models/bot_level_3
+# Kích thước bàn cố định lúc biên dịch: BOARD_SIZE=15 bash run.sh
+SIZE_FLAG="-DGOMOKU_BOARD_SIZE=${BOARD_SIZE:-20}"
+
+g++ -O3 $SIZE_FLAG modules/logic/engine.cpp -o modules/logic/engine
+
+g++ -O3 $SIZE_FLAG modules/models/bot_level_1.cpp -o modules/models/bot_level_1
+g++ -O3 $SIZE_FLAG modules/models/bot_level_2.cpp -o modules/models/bot_level_2
+g++ -O3 -pthread $SIZE_FLAG modules/models/bot_level_3.cpp -o modules/models/bot_level_3
 
 # Biên dịch bot final (kế thừa bot 3)
-g++ -O3 modules/models/bot_final.cpp -o modules/models/bot_final
+g++ -O3 -pthread $SIZE_FLAG modules/models/bot_final.cpp -o modules/models/bot_final
+
+# Tiến trình host nhiều ván (bot level 3 / final)
+g++ -O3 -pthread $SIZE_FLAG modules/models/game_host.cpp -o modules/models/game_host
 
+chmod +x modules/logic/engine
 chmod +x modules/models/bot_level_1
 chmod +x modules/models/bot_level_2
 chmod +x modules/models/bot_level_3
 chmod +x modules/models/bot_final
+chmod +x modules/models/game_host
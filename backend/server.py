@@ -1,7 +1,7 @@
 import eventlet
 eventlet.monkey_patch()
 
-import subprocess, uuid, os, threading
+import subprocess, uuid, os, threading, queue, struct, itertools, json
 from flask import Flask, request, jsonify
 from flask_cors import CORS
 from flask_socketio import SocketIO, emit
@@ -14,14 +14,49 @@ socketio = SocketIO(app, cors_allowed_origins="*", async_mode='eventlet', ping_t
 
 sessions = {}
 
+# Level 3 bots log one JSON object per line. The log panel gets a readable
+# line and 'bot_info' carries the parsed object for dashboards.
+def emit_bot_log(line, room):
+    try:
+        info = json.loads(line)
+    except ValueError:
+        socketio.emit('bot_log', {'log': line}, room=room)
+        return
+    kind = info.get('type')
+    if kind == 'info':
+        text = (f"info depth {info['depth']} seldepth {info['seldepth']} score {info['score']} "
+                f"nodes {info['nodes']} nps {info['nps']} time {info['time']}ms pv {' '.join(info['pv'])}")
+        if info.get('timeout'): text += " [timeout]"
+    elif kind == 'threat':
+        text = f"info {info['solver']} {info['result']} {info['move']} time {info['time']}ms"
+    elif kind == 'bestmove':
+        text = (f"bestmove {info['move']} ({info['reason']}) depth {info['depth']} nodes {info['nodes']} "
+                f"time {info['time']}ms tt {info['tt_fill'] / 10:.1f}% hit {info['tt_hit_rate'] * 100:.1f}%")
+    else:
+        text = f"info {kind} {info.get('move', '')}"
+    socketio.emit('bot_log', {'log': text}, room=room)
+    socketio.emit('bot_info', info, room=room)
+
 class Manager:
     def __init__(self, model_name, game_id):
         self.game_id = game_id
         self.engine = subprocess.Popen([PATH_LOGIC], stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1)
         
         model_exec = os.path.join(PATH_MODELS, model_name)
+        args = [model_exec, "--size", str(BOARD_SIZE), "--threads", str(BOT_THREADS), "--hash", str(TT_SIZE_MB)]
+        if TT_SHARED:
+            args += ["--shared-hash", f"/gomoku_tt_{model_name}"]
+        if SYM_HASH:
+            args += ["--sym-hash", "1"]
+        if USE_DFPN:
+            args += ["--dfpn", "1"]
+        if model_name in HOSTED_MODELS:
+            if BOT_PONDER: args += ["--ponder", "1"]
+            if MOVE_BUDGET_MS: args += ["--time", str(MOVE_BUDGET_MS)]
+            if GAME_CLOCK_MS: args += ["--clock", str(GAME_CLOCK_MS)]
+            if os.path.exists(OPENING_BOOK): args += ["--book", OPENING_BOOK]
         self.ai = subprocess.Popen(
-            [model_exec], 
+            args, 
             stdin=subprocess.PIPE, 
             stdout=subprocess.PIPE, 
             stderr=subprocess.PIPE, 
@@ -38,7 +73,7 @@ class Manager:
                 if line:
                     clean_line = line.strip()
                     if clean_line:
-                        socketio.emit('bot_log', {'log': clean_line}, room=self.game_id)
+                        emit_bot_log(clean_line, self.game_id)
         except Exception:
             pass
 
@@ -54,16 +89,139 @@ class Manager:
             return int(self.ai.stdout.readline().strip())
         except: return -1
 
+    def play(self, idx):
+        if idx != -1:
+            st = self.send_engine(idx, 1)
+            if st != 0: return st, -1, 0
+        ai_idx = self.get_ai(idx)
+        return 0, ai_idx, self.send_engine(ai_idx, 2)
+
     def close(self):
+        # On EOF the bot exits by itself and detaches from the shared table.
         try:
             self.engine.terminate()
-            self.ai.terminate()
-        except: pass
+            self.ai.stdin.close()
+            self.ai.wait(timeout=2)
+        except:
+            try: self.ai.terminate()
+            except: pass
+
+# Frames exchanged with game_host (see HostRequest/HostReply in game_host.cpp)
+HOST_REQUEST = struct.Struct('<IIBhI')
+HOST_REPLY = struct.Struct('<IIbhb')
+OP_NEW, OP_PLAY, OP_END = 0, 1, 2
+HOST_FAILED = (-1, -1, 0)
+
+class GameHost:
+    def __init__(self):
+        args = [PATH_HOST, "--model", CURRENT_MODEL, "--size", str(BOARD_SIZE), "--workers", str(HOST_WORKERS),
+                "--threads", str(BOT_THREADS), "--hash", str(TT_SIZE_MB)]
+        if USE_DFPN:
+            args += ["--dfpn", "1"]
+        if SYM_HASH:
+            args += ["--sym-hash", "1"]
+        if os.path.exists(OPENING_BOOK):
+            args += ["--book", OPENING_BOOK]
+        self.proc = subprocess.Popen(args, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, bufsize=0)
+        self.lock = threading.Lock()
+        self.pending = {}
+        self.rooms = {}
+        self.ids = itertools.count(1)
+        self.seqs = itertools.count(1)
+        self.dead = False
+        threading.Thread(target=self.read_replies, daemon=True).start()
+        threading.Thread(target=self.read_logs, daemon=True).start()
+
+    # Waiters are keyed by request, not game: a second request for a game
+    # (double click, reset during a search) must not take over the first.
+    def request(self, hid, op, move=-1, time_ms=0):
+        waiter = queue.Queue(maxsize=1)
+        with self.lock:
+            if self.dead: return HOST_FAILED
+            seq = next(self.seqs) & 0xFFFFFFFF
+            self.pending[seq] = waiter
+            try:
+                self.proc.stdin.write(HOST_REQUEST.pack(hid, seq, op, move, time_ms))
+            except OSError:
+                self.pending.pop(seq, None)
+                return HOST_FAILED
+        try:
+            return waiter.get(timeout=HOST_TIMEOUT_S)
+        except queue.Empty:
+            with self.lock: self.pending.pop(seq, None)
+            return HOST_FAILED
+
+    def read_exact(self, n):
+        buf = b''
+        while len(buf) < n:
+            chunk = self.proc.stdout.read(n - len(buf))
+            if not chunk: return None
+            buf += chunk
+        return buf
+
+    def read_replies(self):
+        while True:
+            frame = self.read_exact(HOST_REPLY.size)
+            if frame is None: break
+            hid, seq, st, ai_idx, ai_won = HOST_REPLY.unpack(frame)
+            with self.lock:
+                waiter = self.pending.pop(seq, None)
+            if waiter: waiter.put((st, ai_idx, ai_won))
+        # game_host is gone: every game it held is lost. Fail the waiting
+        # requests and let the next game start a new host.
+        with self.lock:
+            self.dead = True
+            waiters = list(self.pending.values())
+            self.pending.clear()
+        for waiter in waiters: waiter.put(HOST_FAILED)
+
+    def read_logs(self):
+        try:
+            for line in iter(self.proc.stderr.readline, b''):
+                hid, _, text = line.decode().strip().partition(' ')
+                room = self.rooms.get(int(hid)) if hid.isdigit() else None
+                if room and text:
+                    emit_bot_log(text, room)
+        except Exception:
+            pass
+
+host = None
+host_lock = threading.Lock()
+
+def get_host():
+    global host
+    with host_lock:
+        if host is None or host.dead or host.proc.poll() is not None:
+            host = GameHost()
+        return host
+
+# A game stays on the host that started it; after a host restart its
+# requests fail instead of reaching another game with the same id.
+class HostedGame:
+    def __init__(self, game_id):
+        self.host = get_host()
+        self.hid = next(self.host.ids)
+        self.host.rooms[self.hid] = game_id
+        self.host.request(self.hid, OP_NEW, time_ms=GAME_CLOCK_MS)
+
+    def play(self, idx):
+        return self.host.request(self.hid, OP_PLAY, idx, MOVE_BUDGET_MS)
+
+    def close(self):
+        self.host.request(self.hid, OP_END)
+        self.host.rooms.pop(self.hid, None)
+
+@app.route('/config', methods=['GET'])
+def get_config():
+    return jsonify({"board_size": BOARD_SIZE, "win_length": WIN_LENGTH})
 
 @app.route('/start', methods=['POST'])
 def start():
     gid = str(uuid.uuid4())
-    sessions[gid] = Manager(CURRENT_MODEL, gid)
+    if USE_GAME_HOST and CURRENT_MODEL in HOSTED_MODELS:
+        sessions[gid] = HostedGame(gid)
+    else:
+        sessions[gid] = Manager(CURRENT_MODEL, gid)
     return jsonify({"game_id": gid})
 
 @app.route('/move', methods=['POST'])
@@ -73,13 +231,9 @@ def move():
     if gid not in sessions: return jsonify({"error": "No session"}), 404
     mgr = sessions[gid]
     
-    if idx != -1:
-        st = mgr.send_engine(idx, 1)
-        if st == -1: return jsonify({"error": "Invalid"}), 400
-        if st == 1: return jsonify({"win": True, "winner": "X", "move": idx})
-    
-    ai_idx = mgr.get_ai(idx)
-    st_ai = mgr.send_engine(ai_idx, 2)
+    st, ai_idx, st_ai = mgr.play(idx)
+    if st == -1: return jsonify({"error": "Invalid"}), 400
+    if st == 1: return jsonify({"win": True, "winner": "X", "move": idx})
     if st_ai == 1: return jsonify({"win": True, "winner": "O", "move": ai_idx})
     
     return jsonify({"win": False, "move": ai_idx})
@@ -1,5 +1,6 @@
-const BOARD_SIZE = 20;
-const WIN_LENGTH = 5;
+// Lấy từ server qua /config, giá trị này chỉ dùng khi không kết nối được
+let BOARD_SIZE = 20;
+let WIN_LENGTH = 5;
 const API_URL = "http://{your_ip_address}:5000"; // Thêm :5000 vào đuôi
 
 const board = document.getElementById("board");
@@ -25,6 +26,18 @@ let turn = "X";
 let playerRole = "X";
 let boardState = [];
 let socket = null;
+let configLoaded = false;
+
+async function loadConfig() {
+    if (configLoaded) return;
+    try {
+        const res = await fetch(`${API_URL}/config`);
+        const data = await res.json();
+        BOARD_SIZE = data.board_size;
+        WIN_LENGTH = data.win_length;
+        configLoaded = true;
+    } catch (e) { console.error(e); }
+}
 
 function createBoard() {
     board.innerHTML = "";
@@ -53,6 +66,7 @@ async function startGame(mode, role = null) {
     gameMode = mode;
     menu.classList.add("hide");
     gameContainer.classList.remove("hide");
+    await loadConfig();
     createBoard();
     resetUI();
 